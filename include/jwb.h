@@ -5,7 +5,9 @@
 extern "C" { /* C++ compatability */
 #endif
 
+#include <limits.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /**
  * # Just Wheels Bouncing
@@ -29,6 +31,10 @@ extern "C" { /* C++ compatability */
  *    never be more than the number initially accounted for.
  *  * `JWBO_NUM_FLOAT`: The numeric type is switched to `float`, rather than the
  *    default, which is `double`. This can save some space.
+ *  * `JWBO_NUM_FIXED`: The numeric type is switched to a fixed-point number
+ *    with 16 fractional bits, stored in a `long` (which must be 64 bits.) The
+ *    simulation then uses only integer arithmetic, so it gives the same results
+ *    on every platform. See `jwb_num_t`.
  *  * `JWBO_EXTRA_ALIGN_4`: Align the extra data of entities to a 4-byte
  *    boundary. This saves a bit, but is less flexible than the default 8-byte
  *    alignment.
@@ -36,7 +42,26 @@ extern "C" { /* C++ compatability */
  *    effectively always active. See `struct jwb_world_init`.
  *  * `JWBO_NEVER_REMOVE_DISTANT`: The flag `JWBF_REMOVE_DISTANT` is
  *    effectively always inactive. See `struct jwb_world_init`.
- */
+ *  * `JWBO_PAGED_ENTS`: Store entities in fixed-size pages of 1024 rather than
+ *    in one buffer. Adding an entity then never copies the existing ones, and
+ *    entities never move in memory except when the world is compacted with
+ *    `jwb_world_compact`. `jwb_world_shrink_to_fit` can also free pages no
+ *    longer in use. Entity buffers cannot be provided by the user, so this
+ *    cannot be combined with `JWBO_NO_ALLOC`.
+ *  * `JWBO_HANDLE_32`: Entity handles are `int` rather than `long`, which must
+ *    be at least 32 bits. This shrinks entities and halves the cell buffer on
+ *    platforms where `long` is 64 bits, but limits a world to about two billion
+ *    entities and cells.
+ */
+#if defined(JWBO_NUM_FIXED) && defined(JWBO_NUM_FLOAT)
+#	error JWBO_NUM_FIXED cannot be used with JWBO_NUM_FLOAT.
+#endif
+#if defined(JWBO_PAGED_ENTS) && defined(JWBO_NO_ALLOC)
+#	error JWBO_PAGED_ENTS cannot be used with JWBO_NO_ALLOC.
+#endif
+#if defined(JWBO_HANDLE_32) && INT_MAX < 2147483647
+#	error JWBO_HANDLE_32 requires int to be at least 32 bits.
+#endif
 
 /**
  * ## Error Handling
@@ -53,11 +78,18 @@ extern "C" { /* C++ compatability */
  *    destroyed entity. This indicates something wrong with your program, and
  *    you should probably abort upon receiving this.
  *  * `JWBE_INVALID_ARGUMENT`: An invalid argument was passed to a function.
+ *  * `JWBE_IO`: Reading or writing a file failed.
+ *  * `JWBE_BAD_SNAPSHOT`: A snapshot was damaged or saved by an incompatible
+ *    build of the library.
+ *  * `JWBE_BAD_RECORDING`: A recording was damaged.
  */
 #define JWBE_NO_MEMORY 1
 #define JWBE_REMOVED_ENTITY 2
 #define JWBE_DESTROYED_ENTITY 3
 #define JWBE_INVALID_ARGUMENT 4
+#define JWBE_IO 5
+#define JWBE_BAD_SNAPSHOT 6
+#define JWBE_BAD_RECORDING 7
 /**
  * ### `jwb_errmsg`
  * ```
@@ -81,8 +113,20 @@ const char *jwb_errmsg(int errcode);
  * This is the scalar type for all floating-point calculations in the library.
  * The default is `double`, but `float` can be specified by defining
  * `JWBO_NUM_FLOAT` during compilation.
+ *
+ * With `JWBO_NUM_FIXED`, this is a `long` holding the number multiplied by
+ * 65536. Numbers must then be converted with `JWB_NUM` and
+ * `JWB_NUM_TO_DOUBLE`, and a world should stay within about 30000 units of the
+ * origin in order for products not to overflow. The functions which convert
+ * between rotations and angles still use floating-point math internally, but
+ * the simulation never calls them.
  */
-#ifdef JWBO_NUM_FLOAT
+#ifdef JWBO_NUM_FIXED
+#	if (LONG_MAX >> 31) >> 31 == 0
+#		error long is not 64 bits.
+#	endif
+typedef long jwb_num_t;
+#elif defined(JWBO_NUM_FLOAT)
 #	if !(__FLT_MANT_DIG__ == 24 && __FLT_MAX_EXP__ == 128)
 #		error float is not 32 bits.
 #	endif
@@ -94,6 +138,32 @@ typedef float jwb_num_t;
 typedef double jwb_num_t;
 #endif
 
+/**
+ * ### `JWB_NUM`
+ * ```
+ * #define JWB_NUM(x) ...
+ * ```
+ *
+ * Convert a floating-point number to `jwb_num_t`, rounding to the nearest
+ * fixed-point number if `JWBO_NUM_FIXED` is defined. This can be used in
+ * constant expressions. The argument may be evaluated more than once.
+ *
+ * ### `JWB_NUM_TO_DOUBLE`
+ * ```
+ * #define JWB_NUM_TO_DOUBLE(num) ...
+ * ```
+ *
+ * Convert a `jwb_num_t` to a `double`.
+ */
+#ifdef JWBO_NUM_FIXED
+#	define JWB_NUM(x) \
+	((jwb_num_t)((x) * 65536. + ((x) < 0 ? -.5 : .5)))
+#	define JWB_NUM_TO_DOUBLE(num) ((double)(num) / 65536.)
+#else
+#	define JWB_NUM(x) ((jwb_num_t)(x))
+#	define JWB_NUM_TO_DOUBLE(num) ((double)(num))
+#endif
+
 
 /**
  * ## Rotation
@@ -214,6 +284,8 @@ jwb_num_t jwb_vect_magnitude(const struct jwb_vect *vect);
  * ```
  *
  * Change the magnitude of a vector to 1 while keeping the x/y ratio the same.
+ * A vector whose magnitude is zero (including one so short that its magnitude
+ * rounds to zero) is left unchanged.
  *
  * #### Parameters
  *  1. `vect`: The vector to shorten or lengthen.
@@ -242,7 +314,8 @@ jwb_num_t jwb_vect_angle(const struct jwb_vect *vect);
  * void jwb_vect_rotation(const struct jwb_vect *vect, jwb_rotation_t *rot);
  * ```
  *
- * Get the rotation from the x-axis to the arm of a vector.
+ * Get the rotation from the x-axis to the arm of a vector. A vector whose
+ * magnitude is zero gives no rotation, with a cosine of 1 and a sine of 0.
  *
  * #### Parameters
  *  1. `vect`: The vector to measure.
@@ -260,18 +333,25 @@ void jwb_vect_rotation(const struct jwb_vect *vect, jwb_rotation_t *rot);
  * ### `jwb_ehandle_t`
  * An entity handle, representing a certain entity for a certain world. Valid
  * operations on a handle are comparison to zero and passing to appropriate
- * methods, but nothing else.
+ * methods, but nothing else. This is `long`, or `int` if `JWBO_HANDLE_32` is
+ * defined.
  */
+#ifdef JWBO_HANDLE_32
+typedef int jwb_ehandle_t;
+#else
 typedef long jwb_ehandle_t;
+#endif
 
 #define JWB__ALIGN(num, size) (((num) + (size) - 1) / (size) * (size))
 
 struct jwb__entity {
 	jwb_ehandle_t next, last;
+	jwb_ehandle_t dense; /* Index in the list of living entities */
 	struct jwb_vect pos, vel;
 	struct jwb_vect correct; /* Correctional displacement */
 	jwb_num_t mass;
 	jwb_num_t radius;
+	unsigned category, mask; /* Collision filtering bits */
 	int flags;
 #ifndef JWBO_EXTRA_ALIGN_4
 	/* Extra has 8-byte alignment. */
@@ -280,7 +360,8 @@ struct jwb__entity {
 #	define JWB__ENTITY_SIZE(extra) \
 	(sizeof(struct jwb__entity) - 8 + JWB__ALIGN((extra), 8))
 #	define JWB__ENTITY_EXTRA_MIN_SIZE 0
-#elif defined(JWBO_NUM_FLOAT) && ULONG_MAX == 4294967295
+#elif defined(JWBO_NUM_FLOAT) \
+	&& (defined(JWBO_HANDLE_32) || ULONG_MAX == 4294967295)
 	/* Struct has 4-byte alignment. */
 	char extra[1 /* Variadic */];
 #	define JWB__ENTITY_SIZE(extra) \
@@ -329,6 +410,31 @@ typedef void (*jwb_hit_handler_t)(
 	jwb_ehandle_t e2,
 	struct jwb_hit_info *info);
 
+/**
+ * ### `jwb_contact_handler_t`
+ * ```
+ * typedef void (*jwb_contact_handler_t)(
+ *   jwb_world_t *world,
+ *   jwb_ehandle_t e1,
+ *   jwb_ehandle_t e2);
+ * ```
+ * A function called when two circles start or stop touching. See
+ * `jwb_world_on_contact`.
+ *
+ * #### Parameters
+ *  1. `world`: The world where the interaction takes place.
+ *  2. `e1`: The first involved entity. This is always the lesser handle.
+ *  3. `e2`: The second involved entity.
+ *
+ * #### Allowed Operations
+ * The same operations are allowed as in a hit handler. When contact ends, the
+ * entities might have been removed or destroyed since they last touched.
+ */
+typedef void (*jwb_contact_handler_t)(
+	struct jwb__world *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2);
+
 /**
  * ### `struct jwb_hit_info`
  * ```
@@ -350,6 +456,230 @@ struct jwb_hit_info {
 	jwb_num_t dist;
 };
 
+/**
+ * ### `struct jwb_allocator`
+ * ```
+ * struct jwb_allocator {
+ *   void *(*alloc)(void *ctx, size_t size);
+ *   void *(*realloc)(void *ctx, void *ptr, size_t size);
+ *   void (*free)(void *ctx, void *ptr);
+ *   void *ctx;
+ * };
+ * ```
+ *
+ * A set of functions through which a world gets all of its memory. The
+ * functions behave like `malloc`, `realloc`, and `free`, but each is also given
+ * `ctx`. `free` may be given `NULL`, which it should ignore.
+ *
+ * #### Fields
+ *  * `alloc`: Allocate a block of `size` bytes, returning `NULL` on failure.
+ *  * `realloc`: Resize the block `ptr` (which may be `NULL`) to `size` bytes,
+ *    returning the new block, or `NULL` on failure (leaving `ptr` intact.)
+ *  * `free`: Release the block `ptr`.
+ *  * `ctx`: Arbitrary user data passed to each function.
+ */
+struct jwb_allocator {
+	void *(*alloc)(void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *ptr, size_t size);
+	void (*free)(void *ctx, void *ptr);
+	void *ctx;
+};
+
+/**
+ * ### `struct jwb_ray_hit`
+ * ```
+ * struct jwb_ray_hit {
+ *   jwb_ehandle_t ent;
+ *   jwb_num_t dist;
+ *   struct jwb_vect normal;
+ * };
+ * ```
+ *
+ * Where a ray hit an entity. See `jwb_world_raycast`.
+ *
+ * #### Fields
+ *  * `ent`: The entity which was hit.
+ *  * `dist`: The distance along the ray to the hit.
+ *  * `normal`: The unit vector pointing out of the entity where it was hit. If
+ *    the ray starts inside the entity, this points back along the ray.
+ */
+struct jwb_ray_hit {
+	jwb_ehandle_t ent;
+	jwb_num_t dist;
+	struct jwb_vect normal;
+};
+
+/**
+ * ### `jwb_ray_filter_t`
+ * ```
+ * typedef int (*jwb_ray_filter_t)(jwb_world_t *world, jwb_ehandle_t ent);
+ * ```
+ * A function deciding which entities a ray can hit. See `jwb_world_raycast`.
+ *
+ * #### Parameters
+ *  1. `world`: The world being searched.
+ *  2. `ent`: An entity which the ray may pass near.
+ *
+ * #### Return Value
+ * Nonzero if the ray can hit the entity, or 0 if the ray passes through it.
+ *
+ * #### Allowed Operations
+ * Only getters are allowed.
+ */
+typedef int (*jwb_ray_filter_t)(struct jwb__world *world, jwb_ehandle_t ent);
+
+/**
+ * ### `struct jwb_neighbor`
+ * ```
+ * struct jwb_neighbor {
+ *   jwb_ehandle_t ent;
+ *   jwb_num_t dist;
+ * };
+ * ```
+ *
+ * An entity near a point. See `jwb_world_knn`.
+ *
+ * #### Fields
+ *  * `ent`: The nearby entity.
+ *  * `dist`: The distance from the point to the center of the entity.
+ */
+struct jwb_neighbor {
+	jwb_ehandle_t ent;
+	jwb_num_t dist;
+};
+
+/**
+ * ### `struct jwb_pair`
+ * ```
+ * struct jwb_pair {
+ *   jwb_ehandle_t ent1, ent2;
+ *   struct jwb_hit_info info;
+ * };
+ * ```
+ *
+ * Two entities which are close together. See `jwb_world_pairs`.
+ *
+ * #### Fields
+ *  * `ent1`: The first entity. This is always the lesser handle.
+ *  * `ent2`: The second entity.
+ *  * `info`: The offset from the first entity to the second and its magnitude.
+ *    In worlds which wrap around, this is the shortest offset.
+ */
+struct jwb_pair {
+	jwb_ehandle_t ent1, ent2;
+	struct jwb_hit_info info;
+};
+
+/**
+ * ### `struct jwb_contact`
+ * ```
+ * struct jwb_contact {
+ *   jwb_ehandle_t ent1, ent2;
+ *   struct jwb_hit_info info;
+ *   jwb_num_t impulse;
+ * };
+ * ```
+ *
+ * A hit recorded during a step. See `jwb_world_record_contacts`.
+ *
+ * #### Fields
+ *  * `ent1`: The first entity, as given to the hit handler.
+ *  * `ent2`: The second entity.
+ *  * `info`: The hit information given to the hit handler.
+ *  * `impulse`: The change in the momentum of `ent2` made by the hit handler,
+ *    along the direction from `ent1` to `ent2`. The opposite impulse is usually
+ *    applied to `ent1`. This is positive when the entities are pushed apart.
+ */
+struct jwb_contact {
+	jwb_ehandle_t ent1, ent2;
+	struct jwb_hit_info info;
+	jwb_num_t impulse;
+};
+
+/**
+ * ### `struct jwb_visible`
+ * ```
+ * struct jwb_visible {
+ *   jwb_ehandle_t ent;
+ *   struct jwb_vect pos;
+ *   jwb_num_t radius;
+ * };
+ * ```
+ *
+ * An entity in view. See `jwb_world_visible`.
+ *
+ * #### Fields
+ *  * `ent`: The entity.
+ *  * `pos`: Where to draw the entity, relative to the world offset.
+ *  * `radius`: The radius of the entity.
+ */
+struct jwb_visible {
+	jwb_ehandle_t ent;
+	struct jwb_vect pos;
+	jwb_num_t radius;
+};
+
+/**
+ * ### `jwb_write_t`
+ * ```
+ * typedef int (*jwb_write_t)(void *ctx, const void *data, size_t size);
+ * ```
+ *
+ * A function which writes bytes to a stream, such as a file. It should return
+ * 0 on success and anything else on failure. See `jwb_world_record_frames`.
+ */
+typedef int (*jwb_write_t)(void *ctx, const void *data, size_t size);
+
+/**
+ * ### `struct jwb_frame_ent`
+ * ```
+ * struct jwb_frame_ent {
+ *   jwb_ehandle_t ent;
+ *   struct jwb_vect pos;
+ *   jwb_num_t radius;
+ * };
+ * ```
+ *
+ * An entity in a recorded frame. See `jwb_reader_ents`.
+ *
+ * #### Fields
+ *  * `ent`: The handle the entity had in the world.
+ *  * `pos`: The position, rounded to the quantum of the recording.
+ *  * `radius`: The radius, rounded to the quantum of the recording.
+ */
+struct jwb_frame_ent {
+	jwb_ehandle_t ent;
+	struct jwb_vect pos;
+	jwb_num_t radius;
+};
+
+struct jwb__key_frame {
+	long frame;
+	size_t offset;
+};
+
+/**
+ * ### `jwb_reader_t`
+ * A reader of a recording made with `jwb_world_record_frames`. The fields are
+ * private.
+ */
+typedef struct jwb__reader {
+	const unsigned char *data;
+	size_t size;
+	size_t start, next; /* Offsets of the first and next frames */
+	long frame;
+	double quantum;
+	/* What is known of each handle which has been spawned, in order of
+	 * handle. All three share one allocation, starting at `state`. */
+	long *state; /* Position and radius in quanta */
+	jwb_ehandle_t *handles;
+	unsigned char *living;
+	size_t n_handles, handles_cap;
+	struct jwb__key_frame *keys; /* Known key frames, in order */
+	size_t n_keys, keys_cap;
+	struct jwb_allocator allocator;
+} jwb_reader_t;
+
 /**
  * ### `jwb_world_t`
  * The world itself. This structure holds and manages a number of entities. It
@@ -358,16 +688,47 @@ struct jwb_hit_info {
 typedef struct jwb__world {
 	jwb_num_t cell_size;
 	struct jwb_vect offset;
+	struct jwb_vect gravity;
+	jwb_num_t friction;
+	jwb_num_t damping;
 	jwb_hit_handler_t on_hit;
 	size_t width, height;
 	size_t n_ents;
 	size_t ent_cap;
 	size_t ent_size;
+	size_t extra_size; /* Size of out-of-line extra data, or 0 if inline */
 	jwb_ehandle_t *cells;
+	size_t cell_cap;
+#ifdef JWBO_PAGED_ENTS
+	char **ents;
+	size_t dir_cap;
+#else
 	char *ents;
+	char *extras;
+	jwb_ehandle_t *alive;
+#endif
+	size_t n_alive;
 	jwb_ehandle_t freed;
 	jwb_ehandle_t available;
 	jwb_ehandle_t tracking;
+	void *tree;
+	size_t tree_cap;
+	jwb_contact_handler_t on_contact_begin;
+	jwb_contact_handler_t on_contact_end;
+	void *contacts;
+	size_t contacts_cap;
+	size_t n_contacts;
+	unsigned long contact_pass;
+	struct jwb_contact *recorded;
+	size_t recorded_cap;
+	size_t n_recorded;
+	int recording;
+	unsigned *cell_filters;
+	size_t cell_filters_cap;
+	int cell_filtering;
+	void *recorder;
+	unsigned regrid_interval, regrid_countdown;
+	struct jwb_allocator allocator;
 	int flags;
 } jwb_world_t;
 
@@ -383,6 +744,7 @@ typedef struct jwb__world {
  *   size_t ent_extra;
  *   void *ent_buf;
  *   void *cell_buf;
+ *   const struct jwb_allocator *allocator;
  * };
  * ```
  *
@@ -391,6 +753,14 @@ typedef struct jwb__world {
  * #### Fields
  *  * `flags`: The flags which the world should have. Valid flags:
  *    - `JWBF_REMOVE_DISTANT`: Remove off-grid entities rather than wrapping.
+ *    - `JWBF_WALLED`: Bounce entities off the edges of the grid rather than
+ *      wrapping. This has no effect if distant entities are being removed.
+ *    - `JWBF_SEPARATE_EXTRA`: Store the extra space of entities in its own
+ *      array rather than in each entity. The simulation then does not have to
+ *      step over the extra data.
+ *    - `JWBF_CELL_FILTERS`: Before checking collisions, combine the collision
+ *      filters of the entities in each cell so that whole pairs of cells whose
+ *      entities can't hit each other are skipped. See `jwb_world_set_filter`.
  *  * `cell_size`: The size of cells in the world.
  *  * `width`: The width of the world in cells.
  *  * `height`: The height of the world in cells.
@@ -399,10 +769,15 @@ typedef struct jwb__world {
  *  * `ent_extra`: Extra space to allocate for each entity.
  *  * `ent_buf`: The entity buffer. If this is `NULL`, a new one is allocated. A
  *    buffer of size `JWB_WORLD_ENT_BUF_SIZE(...)` must be provided if
- *    allocation is turned off.
+ *    allocation is turned off. This must be `NULL` if `JWBO_PAGED_ENTS` is
+ *    defined.
  *  * `cell_buf`: The cell buffer. If this is `NULL`, a new one is allocated. A
  *    buffer of size `JWB_WORLD_CELL_BUF_SIZE(...)` must be provided if
  *    allocation is turned off.
+ *  * `allocator`: The functions used for all of the world's memory, which are
+ *    copied into the world. If this is `NULL`, `malloc`, `realloc`, and `free`
+ *    are used. This is ignored if allocation is turned off. Buffers given in
+ *    `ent_buf` and `cell_buf` are never freed or resized.
  */
 struct jwb_world_init {
 	int flags;
@@ -413,8 +788,12 @@ struct jwb_world_init {
 	size_t ent_extra;
 	void *ent_buf;
 	void *cell_buf;
+	const struct jwb_allocator *allocator;
 };
 #define JWBF_REMOVE_DISTANT (1 << 0)
+#define JWBF_WALLED (1 << 3)
+#define JWBF_SEPARATE_EXTRA (1 << 5)
+#define JWBF_CELL_FILTERS (1 << 6)
 
 /**
  * ### `JWB_WORLD_INIT_DEFAULT`
@@ -427,13 +806,14 @@ struct jwb_world_init {
  */
 #define JWB_WORLD_INIT_DEFAULT \
 {	/* flags */        0, \
-	/* cell_size */    1, \
+	/* cell_size */    JWB_NUM(1), \
 	/* width */        1, \
 	/* height */       1, \
 	/* ent_buf_size */ 0, \
 	/* ent_extra */    0, \
 	/* ent_buf */   NULL, \
-	/* cell_buf */  NULL}
+	/* cell_buf */  NULL, \
+	/* allocator */ NULL}
 
 /**
  * ### `jwb_world_alloc`
@@ -471,8 +851,11 @@ int jwb_world_alloc(jwb_world_t *world, struct jwb_world_init *info);
  * #### Return Value
  * The needed buffer size in bytes.
  */
-#define JWB_WORLD_ENT_BUF_SIZE(flags, num, extra_space) ((void)(flags), \
-	(num) * JWB__ENTITY_SIZE(extra_space))
+#define JWB_WORLD_ENT_BUF_SIZE(flags, num, extra_space) ((num) \
+	* ((flags) & JWBF_SEPARATE_EXTRA \
+		? JWB__ENTITY_SIZE(0) + JWB__ALIGN((extra_space), 8) \
+		: JWB__ENTITY_SIZE(extra_space)) \
+	+ (num) * sizeof(jwb_ehandle_t))
 
 /**
  * ### `JWB_WORLD_CELL_BUF_SIZE`
@@ -595,6 +978,87 @@ void jwb_no_overlap(
  */
 void jwb_world_apply_friction(jwb_world_t *world, jwb_num_t friction);
 
+/**
+ * ### `jwb_world_apply_friction_dt`
+ * ```
+ * void jwb_world_apply_friction_dt(
+ *   jwb_world_t *world,
+ *   jwb_num_t friction,
+ *   jwb_num_t dt);
+ * ```
+ *
+ * Apply friction to every entity over a given amount of time. This is like
+ * `jwb_world_apply_friction`, but is meant to go along with `jwb_world_step_dt`.
+ *
+ * #### Parameters
+ *  1. `world`: The world to go through.
+ *  2. `friction`: The frictional acceleration to apply per unit of time.
+ *  3. `dt`: The amount of time over which friction acts.
+ */
+void jwb_world_apply_friction_dt(
+	jwb_world_t *world,
+	jwb_num_t friction,
+	jwb_num_t dt);
+
+/**
+ * ### `struct jwb_long_range`
+ * ```
+ * struct jwb_long_range {
+ *   jwb_num_t strength;
+ *   jwb_num_t theta;
+ *   jwb_num_t softening;
+ * };
+ * ```
+ *
+ * Parameters for long-range forces between all entities, such as gravity. See
+ * `jwb_world_apply_long_range`.
+ *
+ * #### Fields
+ *  * `strength`: The constant of proportionality. The acceleration of an entity
+ *    toward another of mass `m` at distance `r` is `strength * m / r^2`.
+ *    Negative strengths push entities apart.
+ *  * `theta`: The opening angle. Groups of entities whose size divided by their
+ *    distance is less than this are treated as one. Zero gives exact but slow
+ *    results, while around 0.5 is a good tradeoff.
+ *  * `softening`: A length added to distances (in quadrature) to keep forces
+ *    from blowing up when entities are very close.
+ */
+struct jwb_long_range {
+	jwb_num_t strength;
+	jwb_num_t theta;
+	jwb_num_t softening;
+};
+
+/**
+ * ### `jwb_world_apply_long_range`
+ * ```
+ * int jwb_world_apply_long_range(
+ *   jwb_world_t *world,
+ *   const struct jwb_long_range *params,
+ *   jwb_num_t dt);
+ * ```
+ *
+ * Accelerate every entity due to the pull of every other entity over a given
+ * amount of time. This is meant to be called right before stepping. A quadtree
+ * of the entities is built each time, so the cost is O(n log n) rather than
+ * O(n^2). In worlds which wrap around, each entity is pulled toward the nearest
+ * copy of every other.
+ *
+ * #### Parameters
+ *  1. `world`: The world to go through.
+ *  2. `params`: The force parameters. See `struct jwb_long_range`.
+ *  3. `dt`: The amount of time over which the forces act.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_NO_MEMORY`: The tree could not be allocated.
+ *  * `-JWBE_INVALID_ARGUMENT`: `theta` or `softening` was negative.
+ */
+int jwb_world_apply_long_range(
+	jwb_world_t *world,
+	const struct jwb_long_range *params,
+	jwb_num_t dt);
+
 /**
  * ### `jwb_world_first_perm`
  * ```
@@ -651,7 +1115,10 @@ int jwb_world_next_perm(
  * jwb_ehandle_t jwb_world_first(jwb_world_t *world);
  * ```
  *
- * Get the first placed entity for iteration.
+ * Get the first placed entity for iteration. Living entities are kept in a
+ * dense list, so iteration takes time proportional to the number of them. The
+ * order is unspecified. The entity being examined may be removed or destroyed
+ * during iteration, and entities added during iteration are not visited.
  *
  * #### Parameters
  *  1. `world`: The iterated world.
@@ -678,6 +1145,58 @@ jwb_ehandle_t jwb_world_first(jwb_world_t *world);
  */
 jwb_ehandle_t jwb_world_next(jwb_world_t *world, jwb_ehandle_t now);
 
+/**
+ * ### `jwb_world_living`
+ * ```
+ * size_t jwb_world_living(
+ *   jwb_world_t *world,
+ *   size_t start,
+ *   const jwb_ehandle_t **handles);
+ * ```
+ *
+ * Get a contiguous run of handles from the list of living entities. All
+ * living entities can be gone through like so:
+ *
+ * ```
+ * const jwb_ehandle_t *handles;
+ * size_t i, n;
+ * for (i = 0; (n = jwb_world_living(world, i, &handles)) > 0; i += n) {
+ *   // Use handles[0] through handles[n - 1].
+ * }
+ * ```
+ *
+ * The handles are only valid until an entity is added, removed, or destroyed,
+ * or until the world is stepped.
+ *
+ * #### Parameters
+ *  1. `world`: The iterated world.
+ *  2. `start`: The index in the list at which to start.
+ *  3. `handles`: Where to put a pointer to the handles.
+ *
+ * #### Return Value
+ * The number of handles in the run, or 0 if `start` is past the end.
+ */
+size_t jwb_world_living(
+	jwb_world_t *world,
+	size_t start,
+	const jwb_ehandle_t **handles);
+
+/**
+ * ### `jwb_world_living_count`
+ * ```
+ * size_t jwb_world_living_count(jwb_world_t *world);
+ * ```
+ *
+ * Get the number of living entities.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The number of entities which are neither removed nor destroyed.
+ */
+size_t jwb_world_living_count(jwb_world_t *world);
+
 /**
  * ### `jwb_world_first_removed`
  * ```
@@ -712,97 +1231,454 @@ jwb_ehandle_t jwb_world_first_removed(jwb_world_t *world);
 jwb_ehandle_t jwb_world_next_removed(jwb_world_t *world, jwb_ehandle_t now);
 
 /**
- * ### `jwb_world_step`
+ * ### `jwb_world_query_aabb`
  * ```
- * void jwb_world_step(jwb_world_t *world);
+ * size_t jwb_world_query_aabb(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *min,
+ *   const struct jwb_vect *max,
+ *   jwb_ehandle_t *buf,
+ *   size_t buf_size);
  * ```
  *
- * Step the world forward one tick of the simulation.
+ * Find the living entities overlapping an axis-aligned rectangle. Only the
+ * grid cells near the rectangle are looked at. The rectangle is in the same
+ * coordinates as entity positions, so the world offset is accounted for. In
+ * worlds which wrap around, the rectangle wraps around too. Each entity is
+ * found at most once. Entities are assumed to be no bigger than the cell size,
+ * as during simulation.
  *
  * #### Parameters
- *  1. `world`: The world which will be simulated.
+ *  1. `world`: The world to look in.
+ *  2. `min`: The corner of the rectangle with the lowest coordinates.
+ *  3. `max`: The corner of the rectangle with the highest coordinates.
+ *  4. `buf`: Where to put the handles of the entities found. May be NULL if
+ *     `buf_size` is 0.
+ *  5. `buf_size`: The number of handles which fit in `buf`. Any handles past
+ *     this number are not stored.
+ *
+ * #### Return Value
+ * The total number of entities found, which may be more than `buf_size`.
  */
-void jwb_world_step(jwb_world_t *world);
+size_t jwb_world_query_aabb(
+	jwb_world_t *world,
+	const struct jwb_vect *min,
+	const struct jwb_vect *max,
+	jwb_ehandle_t *buf,
+	size_t buf_size);
 
 /**
- * ### `jwb_world_add_ent`
+ * ### `jwb_world_query_circle`
  * ```
- * jwb_ehandle_t jwb_world_add_ent(
+ * size_t jwb_world_query_circle(
  *   jwb_world_t *world,
- *   const struct jwb_vect *pos,
- *   const struct jwb_vect *vel,
- *   jwb_num_t mass,
- *   jwb_num_t radius);
+ *   const struct jwb_vect *center,
+ *   jwb_num_t radius,
+ *   jwb_ehandle_t *buf,
+ *   size_t buf_size);
  * ```
  *
- * Add an entity to the world.
+ * Find the living entities overlapping a circle. This works like
+ * `jwb_world_query_aabb`.
  *
  * #### Parameters
- *  1. `world`: The world to which the entity will be added.
- *  2. `pos`: Where to put the entity. Must not be null.
- *  3. `vel`: The initial velocity of the entity. Must not be null.
- *  4. `mass`: The mass of the entity. Must be greater than zero.
- *  5. `radius`: The radius of the entity. Must be greater than zero.
+ *  1. `world`: The world to look in.
+ *  2. `center`: The center of the circle.
+ *  3. `radius`: The radius of the circle.
+ *  4. `buf`: Where to put the handles of the entities found. May be NULL if
+ *     `buf_size` is 0.
+ *  5. `buf_size`: The number of handles which fit in `buf`.
  *
  * #### Return Value
- *  * A handle on the new entity if successful.
- *  * `-JWBE_NO_MEMORY` if there is no room.
+ * The total number of entities found, which may be more than `buf_size`.
  */
-jwb_ehandle_t jwb_world_add_ent(
+size_t jwb_world_query_circle(
 	jwb_world_t *world,
-	const struct jwb_vect *pos,
-	const struct jwb_vect *vel,
-	jwb_num_t mass,
-	jwb_num_t radius);
+	const struct jwb_vect *center,
+	jwb_num_t radius,
+	jwb_ehandle_t *buf,
+	size_t buf_size);
 
 /**
- * ### `jwb_world_re_add_ent`
+ * ### `jwb_world_raycast`
  * ```
- * int jwb_world_re_add_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * int jwb_world_raycast(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *origin,
+ *   const struct jwb_vect *dir,
+ *   jwb_num_t max_dist,
+ *   jwb_ray_filter_t filter,
+ *   struct jwb_ray_hit *hit);
  * ```
  *
- * Add an entity which was removed.
+ * Find the first living entity hit by a ray. The grid is walked cell by cell
+ * along the ray, so the cost depends on the length of the ray rather than on
+ * the number of entities. In worlds which wrap around, the ray wraps around
+ * too. Entities are assumed to be no bigger than the cell size, as during
+ * simulation.
  *
  * #### Parameters
- *  1. `world`: The world to add the entity to.
- *  2. `ent`: Which entity to add.
+ *  1. `world`: The world to look in.
+ *  2. `origin`: Where the ray starts.
+ *  3. `dir`: The direction of the ray. It does not need to be a unit vector,
+ *     but it can't be zero.
+ *  4. `max_dist`: How far the ray goes. This must be finite.
+ *  5. `filter`: Which entities can be hit, or NULL to allow all of them.
+ *  6. `hit`: Where to store the hit, if there is one.
  *
  * #### Return Value
- *  * `0`: The entity was added or existed already.
- *  * `-JWBE_DESTROYED_ENTITY`: The entity specified does not exist.
+ * 1 if an entity was hit, 0 if not, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_INVALID_ARGUMENT`: A pointer was NULL, `dir` was zero, or
+ *    `max_dist` was negative.
  */
-int jwb_world_re_add_ent(jwb_world_t *world, jwb_ehandle_t ent);
+int jwb_world_raycast(
+	jwb_world_t *world,
+	const struct jwb_vect *origin,
+	const struct jwb_vect *dir,
+	jwb_num_t max_dist,
+	jwb_ray_filter_t filter,
+	struct jwb_ray_hit *hit);
 
 /**
- * ### `jwb_world_remove_ent`
+ * ### `jwb_world_raycast_all`
  * ```
- * int jwb_world_remove_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * size_t jwb_world_raycast_all(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *origin,
+ *   const struct jwb_vect *dir,
+ *   jwb_num_t max_dist,
+ *   jwb_ray_filter_t filter,
+ *   struct jwb_ray_hit *hits,
+ *   size_t hits_size);
  * ```
  *
- * Remove an entity from the world. The space is reserved for future reference.
+ * Find all the living entities hit by a ray. This works like
+ * `jwb_world_raycast`. If the ray wraps around the world far enough to hit an
+ * entity twice, both hits are found.
  *
  * #### Parameters
- *  1. `world`: The world from which to remove the entity.
- *  2. `ent`: The handle of the entity to remove.
+ *  1. `world`: The world to look in.
+ *  2. `origin`: Where the ray starts.
+ *  3. `dir`: The direction of the ray, which can't be zero.
+ *  4. `max_dist`: How far the ray goes. This must be finite.
+ *  5. `filter`: Which entities can be hit, or NULL to allow all of them.
+ *  6. `hits`: Where to put the hits, sorted from nearest to farthest. Only the
+ *     nearest `hits_size` are stored. May be NULL if `hits_size` is 0.
+ *  7. `hits_size`: The number of hits which fit in `hits`.
  *
  * #### Return Value
- *  * `0`: Success.
- *  * `-JWBE_REMOVED_ENTITY`: The entity was removed already.
- *  * `-JWBE_DESTROYED_ENTITY`: The entity was destroyed.
+ * The total number of hits, which may be more than `hits_size`. This is 0 if
+ * the arguments are invalid in the same way as for `jwb_world_raycast`.
  */
-int jwb_world_remove_ent(jwb_world_t *world, jwb_ehandle_t ent);
+size_t jwb_world_raycast_all(
+	jwb_world_t *world,
+	const struct jwb_vect *origin,
+	const struct jwb_vect *dir,
+	jwb_num_t max_dist,
+	jwb_ray_filter_t filter,
+	struct jwb_ray_hit *hits,
+	size_t hits_size);
 
 /**
- * ### `jwb_world_destroy_ent`
+ * ### `jwb_world_knn`
  * ```
- * int jwb_world_destroy_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * size_t jwb_world_knn(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *point,
+ *   size_t k,
+ *   struct jwb_neighbor *out);
  * ```
  *
- * Recycle an entity for reuse. The handle passed is now invalid.
+ * Find the `k` living entities with centers nearest to a point. Rings of cells
+ * are searched outward from the point until no unsearched entity could be
+ * nearer than the ones found. In worlds which wrap around, distances are
+ * measured the shortest way around. To find the neighbors of an entity, search
+ * from its position for `k + 1` entities and skip the entity itself.
+ *
+ * The world is not changed, so searches may run at the same time in different
+ * threads as long as nothing else changes the world.
  *
  * #### Parameters
- *  1. `world`: The world from which to take the entity.
- *  2. `ent`: The handle of the entity to destroy.
+ *  1. `world`: The world to look in.
+ *  2. `point`: Where to search from.
+ *  3. `k`: How many entities to find.
+ *  4. `out`: Where to put the entities found, sorted from nearest to farthest.
+ *     This must have room for `k` of them.
+ *
+ * #### Return Value
+ * The number of entities found. This is less than `k` only if the world has
+ * fewer than `k` living entities.
+ */
+size_t jwb_world_knn(
+	jwb_world_t *world,
+	const struct jwb_vect *point,
+	size_t k,
+	struct jwb_neighbor *out);
+
+/**
+ * ### `jwb_world_knn_batch`
+ * ```
+ * void jwb_world_knn_batch(
+ *   jwb_world_t *world,
+ *   size_t n_points,
+ *   const struct jwb_vect *points,
+ *   size_t k,
+ *   struct jwb_neighbor *out,
+ *   size_t *counts);
+ * ```
+ *
+ * Do `jwb_world_knn` for many points at once. The points are independent, so
+ * to parallelize, split them into ranges and give each thread its own range
+ * with the matching parts of `out` and `counts`.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *  2. `n_points`: The number of points.
+ *  3. `points`: The points to search from.
+ *  4. `k`: How many entities to find for each point.
+ *  5. `out`: Where to put the results. The results for point `i` start at
+ *     `out + i * k`. This must have room for `n_points * k` neighbors.
+ *  6. `counts`: Where to put the number of entities found for each point.
+ */
+void jwb_world_knn_batch(
+	jwb_world_t *world,
+	size_t n_points,
+	const struct jwb_vect *points,
+	size_t k,
+	struct jwb_neighbor *out,
+	size_t *counts);
+
+/**
+ * ### `jwb_world_pairs`
+ * ```
+ * size_t jwb_world_pairs(
+ *   jwb_world_t *world,
+ *   jwb_num_t margin,
+ *   struct jwb_pair *pairs,
+ *   size_t pairs_size);
+ * ```
+ *
+ * Find the pairs of living entities which overlap or are within a margin of
+ * each other. This uses the grid the way stepping does, checking each cell
+ * against its neighbors, but nothing is moved and no hit handlers are called.
+ * This lets the world be used only to find pairs for other physics code. If
+ * the largest entities plus the margin don't fit in a cell, more layers of
+ * neighbors are checked. Each pair is found once.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *  2. `margin`: How far apart the edges of two entities can be for them to be
+ *     a pair. If this is 0, only overlapping entities are found.
+ *  3. `pairs`: Where to put the pairs. May be NULL if `pairs_size` is 0.
+ *  4. `pairs_size`: The number of pairs which fit in `pairs`. Any pairs past
+ *     this number are not stored.
+ *
+ * #### Return Value
+ * The total number of pairs, which may be more than `pairs_size`. This is 0 if
+ * `margin` is negative.
+ */
+size_t jwb_world_pairs(
+	jwb_world_t *world,
+	jwb_num_t margin,
+	struct jwb_pair *pairs,
+	size_t pairs_size);
+
+/**
+ * ### `jwb_world_visible`
+ * ```
+ * size_t jwb_world_visible(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *view_min,
+ *   const struct jwb_vect *view_max,
+ *   struct jwb_visible *buf,
+ *   size_t buf_size);
+ * ```
+ *
+ * Find the living entities which can be seen in a view rectangle, for
+ * rendering. Only the cells under the view are looked at. The view is relative
+ * to the world offset, so a view of the same rectangle follows the tracked
+ * entity. In worlds which wrap around, the grid repeats in every direction. An
+ * entity is found once for each copy of it in view, with the position of that
+ * copy. Entities are assumed to be no bigger than the cell size.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *  2. `view_min`: The corner of the view with the lowest coordinates, relative
+ *     to the world offset.
+ *  3. `view_max`: The corner of the view with the highest coordinates.
+ *  4. `buf`: Where to put the visible entities. May be NULL if `buf_size` is 0.
+ *  5. `buf_size`: The number of entities which fit in `buf`. Any entities past
+ *     this number are not stored.
+ *
+ * #### Return Value
+ * The total number of visible entities, which may be more than `buf_size`.
+ */
+size_t jwb_world_visible(
+	jwb_world_t *world,
+	const struct jwb_vect *view_min,
+	const struct jwb_vect *view_max,
+	struct jwb_visible *buf,
+	size_t buf_size);
+
+/**
+ * ### `jwb_world_step`
+ * ```
+ * void jwb_world_step(jwb_world_t *world);
+ * ```
+ *
+ * Step the world forward one tick of the simulation.
+ *
+ * #### Parameters
+ *  1. `world`: The world which will be simulated.
+ */
+void jwb_world_step(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_step_dt`
+ * ```
+ * int jwb_world_step_dt(jwb_world_t *world, jwb_num_t dt, unsigned substeps);
+ * ```
+ *
+ * Step the world forward by an arbitrary amount of time. Velocities are
+ * measured in distance per unit of time, where `jwb_world_step` advances the
+ * world by exactly one unit. The time is divided into equal substeps, each of
+ * which checks collisions and moves entities once. More substeps make fast
+ * entities less likely to pass through each other.
+ *
+ * #### Parameters
+ *  1. `world`: The world which will be simulated.
+ *  2. `dt`: The amount of time to simulate. Must not be negative.
+ *  3. `substeps`: The number of substeps. Must be at least one.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_INVALID_ARGUMENT`: `dt` was negative or `substeps` was zero.
+ */
+int jwb_world_step_dt(jwb_world_t *world, jwb_num_t dt, unsigned substeps);
+
+/**
+ * ### `jwb_world_add_ent`
+ * ```
+ * jwb_ehandle_t jwb_world_add_ent(
+ *   jwb_world_t *world,
+ *   const struct jwb_vect *pos,
+ *   const struct jwb_vect *vel,
+ *   jwb_num_t mass,
+ *   jwb_num_t radius);
+ * ```
+ *
+ * Add an entity to the world.
+ *
+ * #### Parameters
+ *  1. `world`: The world to which the entity will be added.
+ *  2. `pos`: Where to put the entity. Must not be null.
+ *  3. `vel`: The initial velocity of the entity. Must not be null.
+ *  4. `mass`: The mass of the entity. Must be greater than zero.
+ *  5. `radius`: The radius of the entity. Must be greater than zero.
+ *
+ * #### Return Value
+ *  * A handle on the new entity if successful.
+ *  * `-JWBE_NO_MEMORY` if there is no room.
+ */
+jwb_ehandle_t jwb_world_add_ent(
+	jwb_world_t *world,
+	const struct jwb_vect *pos,
+	const struct jwb_vect *vel,
+	jwb_num_t mass,
+	jwb_num_t radius);
+
+/**
+ * ### `jwb_world_add_ents`
+ * ```
+ * int jwb_world_add_ents(
+ *   jwb_world_t *world,
+ *   size_t num,
+ *   const struct jwb_vect *pos,
+ *   const struct jwb_vect *vel,
+ *   const jwb_num_t *mass,
+ *   const jwb_num_t *radius,
+ *   jwb_ehandle_t *handles);
+ * ```
+ *
+ * Add many entities at once. This is like calling `jwb_world_add_ent` for each,
+ * but the entity buffer grows at most once. Entity `i` is made from `pos[i]`,
+ * `vel[i]`, `mass[i]`, and `radius[i]`. The new entities are put in the list
+ * of living entities sorted by cell, so that ones near each other are visited
+ * together. This takes a little temporary memory, without which they are
+ * added unsorted.
+ *
+ * #### Parameters
+ *  1. `world`: The world to which the entities will be added.
+ *  2. `num`: The number of entities to add.
+ *  3. `pos`: The positions of the entities.
+ *  4. `vel`: The initial velocities of the entities.
+ *  5. `mass`: The masses of the entities. Each must be greater than zero.
+ *  6. `radius`: The radii of the entities. Each must be greater than zero.
+ *  7. `handles`: Where to put the handle of each new entity, or `NULL`.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_NO_MEMORY`: There is no room. No entities were added.
+ */
+int jwb_world_add_ents(
+	jwb_world_t *world,
+	size_t num,
+	const struct jwb_vect *pos,
+	const struct jwb_vect *vel,
+	const jwb_num_t *mass,
+	const jwb_num_t *radius,
+	jwb_ehandle_t *handles);
+
+/**
+ * ### `jwb_world_re_add_ent`
+ * ```
+ * int jwb_world_re_add_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * ```
+ *
+ * Add an entity which was removed.
+ *
+ * #### Parameters
+ *  1. `world`: The world to add the entity to.
+ *  2. `ent`: Which entity to add.
+ *
+ * #### Return Value
+ *  * `0`: The entity was added or existed already.
+ *  * `-JWBE_DESTROYED_ENTITY`: The entity specified does not exist.
+ */
+int jwb_world_re_add_ent(jwb_world_t *world, jwb_ehandle_t ent);
+
+/**
+ * ### `jwb_world_remove_ent`
+ * ```
+ * int jwb_world_remove_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * ```
+ *
+ * Remove an entity from the world. The space is reserved for future reference.
+ *
+ * #### Parameters
+ *  1. `world`: The world from which to remove the entity.
+ *  2. `ent`: The handle of the entity to remove.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_REMOVED_ENTITY`: The entity was removed already.
+ *  * `-JWBE_DESTROYED_ENTITY`: The entity was destroyed.
+ */
+int jwb_world_remove_ent(jwb_world_t *world, jwb_ehandle_t ent);
+
+/**
+ * ### `jwb_world_destroy_ent`
+ * ```
+ * int jwb_world_destroy_ent(jwb_world_t *world, jwb_ehandle_t ent);
+ * ```
+ *
+ * Recycle an entity for reuse. The handle passed is now invalid.
+ *
+ * #### Parameters
+ *  1. `world`: The world from which to take the entity.
+ *  2. `ent`: The handle of the entity to destroy.
  *
  * #### Return Value
  *  * `0`: Success.
@@ -810,6 +1686,191 @@ int jwb_world_remove_ent(jwb_world_t *world, jwb_ehandle_t ent);
  */
 int jwb_world_destroy_ent(jwb_world_t *world, jwb_ehandle_t ent);
 
+/**
+ * ### `jwb_world_remove_ents`
+ * ```
+ * int jwb_world_remove_ents(
+ *   jwb_world_t *world,
+ *   size_t num,
+ *   const jwb_ehandle_t *ents);
+ * ```
+ *
+ * Remove many entities at once, as if by `jwb_world_remove_ent`.
+ *
+ * #### Parameters
+ *  1. `world`: The world from which to remove the entities.
+ *  2. `num`: The number of entities to remove.
+ *  3. `ents`: The handles of the entities to remove.
+ *
+ * #### Return Value
+ * `0` if every entity was removed, otherwise the first error returned by
+ * `jwb_world_remove_ent`. The other entities are still removed.
+ */
+int jwb_world_remove_ents(
+	jwb_world_t *world,
+	size_t num,
+	const jwb_ehandle_t *ents);
+
+/**
+ * ### `jwb_world_destroy_ents`
+ * ```
+ * int jwb_world_destroy_ents(
+ *   jwb_world_t *world,
+ *   size_t num,
+ *   const jwb_ehandle_t *ents);
+ * ```
+ *
+ * Destroy many entities at once, as if by `jwb_world_destroy_ent`.
+ *
+ * #### Parameters
+ *  1. `world`: The world from which to take the entities.
+ *  2. `num`: The number of entities to destroy.
+ *  3. `ents`: The handles of the entities to destroy.
+ *
+ * #### Return Value
+ * `0` if every entity was destroyed, otherwise the first error returned by
+ * `jwb_world_destroy_ent`. The other entities are still destroyed.
+ */
+int jwb_world_destroy_ents(
+	jwb_world_t *world,
+	size_t num,
+	const jwb_ehandle_t *ents);
+
+/**
+ * ### `jwb_world_compact`
+ * ```
+ * void jwb_world_compact(jwb_world_t *world, jwb_ehandle_t *remap);
+ * ```
+ *
+ * Close the holes left in the entity buffer by destroyed entities. Living
+ * entities are given the lowest handles, in order of the cells they are in, and
+ * removed entities the handles after those. Destroyed entities are forgotten.
+ * **All handles are changed.** The tracked entity and tracked contacts are
+ * updated automatically, but contacts involving destroyed entities are
+ * forgotten without calling the end handler.
+ *
+ * #### Parameters
+ *  1. `world`: The world to compact.
+ *  2. `remap`: Where to put the new handle of each entity. For each old handle
+ *     `e`, `remap[e]` is set to its new handle, or -1 if it was destroyed. This
+ *     must have room for `jwb_world_handle_count(world)` handles, or be `NULL`.
+ */
+void jwb_world_compact(jwb_world_t *world, jwb_ehandle_t *remap);
+
+/**
+ * ### `jwb_world_regrid`
+ * ```
+ * int jwb_world_regrid(
+ *   jwb_world_t *world,
+ *   jwb_num_t cell_size,
+ *   size_t width,
+ *   size_t height);
+ * ```
+ *
+ * Change the grid of a world after allocation. The cell buffer is resized if it
+ * was not given by the user, and all living entities are put in their new
+ * cells. Entities keep their positions, but in a wrapping or walled world they
+ * are moved into the new bounds as usual. In a world which removes distant
+ * entities, those now off the grid are removed.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `cell_size`: The new size of cells. No living entity may have a larger
+ *     diameter. If `width` or `height` is 1, the grid is stored as cells half
+ *     this size, so no diameter may be larger than half of `cell_size`.
+ *  3. `width`: The new width of the world in cells.
+ *  4. `height`: The new height of the world in cells.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_NO_MEMORY`: The cell buffer could not be grown. The world is
+ *    unchanged.
+ *  * `-JWBE_INVALID_ARGUMENT`: Invalid parameter, as in `jwb_world_alloc`, or
+ *    a living entity is too large for the cells. The world is unchanged.
+ */
+int jwb_world_regrid(
+	jwb_world_t *world,
+	jwb_num_t cell_size,
+	size_t width,
+	size_t height);
+
+/**
+ * ### `jwb_world_auto_regrid`
+ * ```
+ * void jwb_world_auto_regrid(jwb_world_t *world, unsigned interval);
+ * ```
+ *
+ * Have a world tune its own grid every so many steps. The cells are split or
+ * merged by a whole factor so that the size of the world stays the same. The
+ * cells are made as close as they can be to the largest diameter of a living
+ * entity, which they cannot be smaller than, while there are at most four cells
+ * per living entity (or 64 cells in all.) Failure to grow the cell buffer leaves
+ * the grid as it is.
+ *
+ * #### Parameters
+ *  1. `world`: The world to tune.
+ *  2. `interval`: The number of steps between tunings, counting substeps. Zero
+ *     turns tuning off, which is the default.
+ */
+void jwb_world_auto_regrid(jwb_world_t *world, unsigned interval);
+
+/**
+ * ### `jwb_world_reserve`
+ * ```
+ * int jwb_world_reserve(jwb_world_t *world, size_t num);
+ * ```
+ *
+ * Make room for a number of entities in all, so that the entity buffer does not
+ * need to grow until then. Destroyed entities count, since their handles are
+ * still in use until the world is compacted.
+ *
+ * #### Parameters
+ *  1. `world`: The world to grow.
+ *  2. `num`: The number of entities to make room for.
+ *
+ * #### Return Value
+ *  * `0`: Success, or there was room already.
+ *  * `-JWBE_NO_MEMORY`: The buffer could not be grown, or it was given by the
+ *    user. The world is unchanged.
+ */
+int jwb_world_reserve(jwb_world_t *world, size_t num);
+
+/**
+ * ### `jwb_world_shrink_to_fit`
+ * ```
+ * void jwb_world_shrink_to_fit(jwb_world_t *world);
+ * ```
+ *
+ * Release memory which the world is not using. The entity buffer is shrunk to
+ * the number of handles in use (see `jwb_world_handle_count`), so compact the
+ * world first to release the space of destroyed entities. The cell buffer is
+ * shrunk after a regrid to fewer cells, and auxiliary structures are shrunk or
+ * freed. Buffers given by the user are left alone. Failures leave the affected
+ * part as it was.
+ *
+ * #### Parameters
+ *  1. `world`: The world to shrink.
+ */
+void jwb_world_shrink_to_fit(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_memory_usage`
+ * ```
+ * size_t jwb_world_memory_usage(jwb_world_t *world);
+ * ```
+ *
+ * Get the memory used by a world. This counts the world structure, the cell
+ * buffer, the entity buffer (including any buffers given by the user), and
+ * auxiliary structures such as the contact table.
+ *
+ * #### Parameters
+ *  1. `world`: The world to examine.
+ *
+ * #### Return Value
+ * The size in bytes.
+ */
+size_t jwb_world_memory_usage(jwb_world_t *world);
+
 /**
  * ### `jwb_world_destroy`
  * ```
@@ -823,6 +1884,291 @@ int jwb_world_destroy_ent(jwb_world_t *world, jwb_ehandle_t ent);
  */
 void jwb_world_destroy(jwb_world_t *world);
 
+/**
+ * ### `jwb_world_save`
+ * ```
+ * int jwb_world_save(jwb_world_t *world, FILE *file);
+ * ```
+ *
+ * Write a snapshot of a world to a binary file. The snapshot holds the grid,
+ * the settings, and the raw entity buffer with the extra data of each entity
+ * and the lists of removed and destroyed entities, so handles stay the same
+ * after loading. Handlers, contact tracking, and recorded contacts are not
+ * saved. Snapshots can only be loaded by builds of the library with the same
+ * compilation options on machines of the same kind.
+ *
+ * #### Parameters
+ *  1. `world`: The world to save.
+ *  2. `file`: The file to write to, opened in binary mode.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_INVALID_ARGUMENT`: `file` was `NULL`.
+ *  * `-JWBE_IO`: Writing failed.
+ */
+int jwb_world_save(jwb_world_t *world, FILE *file);
+
+/**
+ * ### `jwb_world_load`
+ * ```
+ * int jwb_world_load(
+ *   jwb_world_t *world,
+ *   FILE *file,
+ *   const struct jwb_allocator *allocator);
+ * ```
+ *
+ * Allocate a world from a snapshot written by `jwb_world_save`. The buffers are
+ * read in directly without adding each entity again. The hit handler is set to
+ * the default.
+ *
+ * #### Parameters
+ *  1. `world`: The world to initialize.
+ *  2. `file`: The file to read from, opened in binary mode.
+ *  3. `allocator`: As in `struct jwb_world_init`.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code. On failure, the world is not
+ * allocated.
+ *
+ * #### Errors
+ *  * `-JWBE_NO_MEMORY`: The world could not be allocated.
+ *  * `-JWBE_INVALID_ARGUMENT`: `file` was `NULL`.
+ *  * `-JWBE_IO`: Reading failed.
+ *  * `-JWBE_BAD_SNAPSHOT`: The file is not a snapshot, ended early, holds
+ *    handles out of range, or was saved by an incompatible build.
+ */
+int jwb_world_load(
+	jwb_world_t *world,
+	FILE *file,
+	const struct jwb_allocator *allocator);
+
+/**
+ * ### `jwb_world_load_mapped`
+ * ```
+ * int jwb_world_load_mapped(
+ *   jwb_world_t *world,
+ *   void *data,
+ *   size_t size,
+ *   const struct jwb_allocator *allocator);
+ * ```
+ *
+ * Allocate a world which uses a snapshot in memory as its cell and entity
+ * buffers, without copying them. This is meant for a snapshot file mapped into
+ * memory, such as with `mmap` using `MAP_PRIVATE` and both read and write
+ * access. The buffers are given to the world as in `struct jwb_world_init`, so
+ * it cannot hold more entities than the snapshot did. The memory must stay
+ * valid and writable until the world is destroyed, and must be aligned to 8
+ * bytes. This is not available if `JWBO_PAGED_ENTS` is defined.
+ *
+ * #### Parameters
+ *  1. `world`: The world to initialize.
+ *  2. `data`: The snapshot.
+ *  3. `size`: The size of the snapshot in bytes.
+ *  4. `allocator`: As in `struct jwb_world_init`.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code. On failure, the world is not
+ * allocated.
+ *
+ * #### Errors
+ *  * `-JWBE_NO_MEMORY`: The world could not be allocated.
+ *  * `-JWBE_INVALID_ARGUMENT`: `data` was `NULL`, or `JWBO_PAGED_ENTS` is
+ *    defined.
+ *  * `-JWBE_BAD_SNAPSHOT`: The memory is not a snapshot, is too small, holds
+ *    handles out of range, or was saved by an incompatible build.
+ */
+int jwb_world_load_mapped(
+	jwb_world_t *world,
+	void *data,
+	size_t size,
+	const struct jwb_allocator *allocator);
+
+/**
+ * ## Recording
+ * The movement of entities can be recorded to a stream, one frame per step,
+ * and played back later. Frames only hold what changed: positions are rounded
+ * to multiples of a quantum and stored as small differences from the last
+ * frame, and entities appearing or disappearing are stored as events. Key
+ * frames hold every entity so that playback can start from them.
+ */
+
+/**
+ * ### `jwb_world_record_frames`
+ * ```
+ * int jwb_world_record_frames(
+ *   jwb_world_t *world,
+ *   jwb_num_t quantum,
+ *   unsigned keyframe_interval,
+ *   jwb_write_t write,
+ *   void *ctx);
+ * ```
+ *
+ * Start or stop recording the positions and radii of living entities. The
+ * first frame, holding the world as it is now, is written right away. After
+ * that, a frame is written at the end of each call to `jwb_world_step` or
+ * `jwb_world_step_dt`. Each frame is written with one call to `write`. Frames
+ * after `jwb_world_compact` are key frames, since the handles change. If a
+ * write fails, nothing more is written, and the error is returned when
+ * recording stops. Any earlier recording is stopped first.
+ *
+ * #### Parameters
+ *  1. `world`: The world to record.
+ *  2. `quantum`: The precision of positions and radii. Smaller quanta take more
+ *     space. This is rounded to a multiple of 1/65536, which is the least it
+ *     can be.
+ *  3. `keyframe_interval`: How many frames there are from one key frame to the
+ *     next, or 0 for only the first frame to be a key frame.
+ *  4. `write`: The function which writes the recording, or `NULL` to stop.
+ *  5. `ctx`: What to pass to `write`.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_NO_MEMORY`: The recording state could not be allocated.
+ *  * `-JWBE_INVALID_ARGUMENT`: `quantum` was too small or too big.
+ *  * `-JWBE_IO`: `write` failed, either now or while recording.
+ */
+int jwb_world_record_frames(
+	jwb_world_t *world,
+	jwb_num_t quantum,
+	unsigned keyframe_interval,
+	jwb_write_t write,
+	void *ctx);
+
+/**
+ * ### `jwb_reader_open`
+ * ```
+ * int jwb_reader_open(
+ *   jwb_reader_t *reader,
+ *   const void *data,
+ *   size_t size,
+ *   const struct jwb_allocator *allocator);
+ * ```
+ *
+ * Start reading a recording in memory. The reader starts before the first
+ * frame, with no entities.
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to initialize.
+ *  2. `data`: The recording, which must stay valid while it is read.
+ *  3. `size`: The size of the recording in bytes. Frames cut off at the end are
+ *     treated as damaged.
+ *  4. `allocator`: As in `struct jwb_world_init`.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_INVALID_ARGUMENT`: `data` was `NULL`.
+ *  * `-JWBE_BAD_RECORDING`: The data is not a recording.
+ */
+int jwb_reader_open(
+	jwb_reader_t *reader,
+	const void *data,
+	size_t size,
+	const struct jwb_allocator *allocator);
+
+/**
+ * ### `jwb_reader_next`
+ * ```
+ * int jwb_reader_next(jwb_reader_t *reader);
+ * ```
+ *
+ * Move to the next frame.
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to move.
+ *
+ * #### Return Value
+ * 1 if a frame was read, 0 at the end of the recording, or a negative error
+ * code.
+ *
+ * #### Errors
+ *  * `-JWBE_NO_MEMORY`: The reader's state could not be grown.
+ *  * `-JWBE_BAD_RECORDING`: The frame is damaged.
+ */
+int jwb_reader_next(jwb_reader_t *reader);
+
+/**
+ * ### `jwb_reader_seek`
+ * ```
+ * int jwb_reader_seek(jwb_reader_t *reader, unsigned long frame);
+ * ```
+ *
+ * Move to a frame, forwards or backwards. Reading starts from the last key
+ * frame before it, skipping over the frames before that key frame without
+ * decoding them.
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to move.
+ *  2. `frame`: The number of the frame, counting from 0.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code. On failure, the reader may be left
+ * at any frame.
+ *
+ * #### Errors
+ *  * `-JWBE_NO_MEMORY`: The reader's state could not be grown.
+ *  * `-JWBE_INVALID_ARGUMENT`: The recording has no such frame.
+ *  * `-JWBE_BAD_RECORDING`: A frame is damaged.
+ */
+int jwb_reader_seek(jwb_reader_t *reader, unsigned long frame);
+
+/**
+ * ### `jwb_reader_frame`
+ * ```
+ * long jwb_reader_frame(jwb_reader_t *reader);
+ * ```
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to look at.
+ *
+ * #### Return Value
+ * The number of the current frame, or -1 before the first frame.
+ */
+long jwb_reader_frame(jwb_reader_t *reader);
+
+/**
+ * ### `jwb_reader_ents`
+ * ```
+ * size_t jwb_reader_ents(
+ *   jwb_reader_t *reader,
+ *   struct jwb_frame_ent *buf,
+ *   size_t buf_size);
+ * ```
+ *
+ * Get the living entities in the current frame, in order of handle.
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to look at.
+ *  2. `buf`: Where to put the entities. May be `NULL` if `buf_size` is 0.
+ *  3. `buf_size`: The number of entities which fit in `buf`. Any entities past
+ *     this number are not stored.
+ *
+ * #### Return Value
+ * The total number of living entities, which may be more than `buf_size`.
+ */
+size_t jwb_reader_ents(
+	jwb_reader_t *reader,
+	struct jwb_frame_ent *buf,
+	size_t buf_size);
+
+/**
+ * ### `jwb_reader_close`
+ * ```
+ * void jwb_reader_close(jwb_reader_t *reader);
+ * ```
+ *
+ * Free the resources of a reader. The recording itself is not freed.
+ *
+ * #### Parameters
+ *  1. `reader`: The reader to close.
+ */
+void jwb_reader_close(jwb_reader_t *reader);
+
 /**
  * ### `jwb_world_confirm_ent`
  * ```
@@ -848,43 +2194,112 @@ int jwb_world_confirm_ent(jwb_world_t *world, jwb_ehandle_t ent);
  * arguments are valid. Unchecked versions might be good where performance is
  * more criticial.
  *
- * Checked versions will _not_ check the validity of the argument `world`.
- * Otherwise, numeric arguments can be restricted to ranges, entity handle
- * arguments are checked for their existence, and pointer arguments are checked
- * both in `NULL`ness and in content. Invalid arguments cause
- * `-JWBE_INVALID_ARGUMENT` to be returned, except in the case of entities,
- * where `-JWBE_ENTITY_DESTROYED` is returned.
+ * Checked versions will _not_ check the validity of the argument `world`.
+ * Otherwise, numeric arguments can be restricted to ranges, entity handle
+ * arguments are checked for their existence, and pointer arguments are checked
+ * both in `NULL`ness and in content. Invalid arguments cause
+ * `-JWBE_INVALID_ARGUMENT` to be returned, except in the case of entities,
+ * where `-JWBE_ENTITY_DESTROYED` is returned.
+ *
+ * Most of these are pretty similar, so the descriptions are short.
+ */
+
+/**
+ * ### `jwb_world_get_hit_handler`
+ * ```
+ * jwb_hit_handler_t jwb_world_get_hit_handler(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to examine.
+ *
+ * #### Return Value
+ * The current hit handler.
+ */
+jwb_hit_handler_t jwb_world_get_hit_handler(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_on_hit`
+ * ```
+ * void jwb_world_on_hit(jwb_world_t *world, jwb_hit_handler_t on_hit);
+ * ```
+ *
+ * Set the hit handler.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `on_hit`: The new hit handler.
+ */
+void jwb_world_on_hit(jwb_world_t *world, jwb_hit_handler_t on_hit);
+
+/**
+ * ### `jwb_world_on_contact`
+ * ```
+ * void jwb_world_on_contact(
+ *   jwb_world_t *world,
+ *   jwb_contact_handler_t begin,
+ *   jwb_contact_handler_t end);
+ * ```
+ *
+ * Set the contact handlers. While either is set, the world remembers which
+ * pairs of entities are touching from step to step. `begin` is called during a
+ * step when a pair first touches, right before the hit handler. `end` is called
+ * once per pair during the first step in which that pair does not touch. If
+ * memory runs out, some contacts may go unreported. Setting both to `NULL`
+ * forgets all current contacts without calling `end`.
  *
- * Most of these are pretty similar, so the descriptions are short.
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `begin`: The handler for new contacts, or `NULL`.
+ *  3. `end`: The handler for ended contacts, or `NULL`.
  */
+void jwb_world_on_contact(
+	jwb_world_t *world,
+	jwb_contact_handler_t begin,
+	jwb_contact_handler_t end);
 
 /**
- * ### `jwb_world_get_hit_handler`
+ * ### `jwb_world_record_contacts`
  * ```
- * jwb_hit_handler_t jwb_world_get_hit_handler(jwb_world_t *world);
+ * void jwb_world_record_contacts(jwb_world_t *world, int record);
  * ```
  *
- * #### Parameters
- *  1. `world`: The world to examine.
+ * Turn contact recording on or off. While it is on, each step records every
+ * hit in a list held by the world, which can be read with
+ * `jwb_world_contacts`. The list is emptied at the start of each call to
+ * `jwb_world_step` or `jwb_world_step_dt`, so it holds the hits from the last
+ * call, including all substeps. Its memory is reused from step to step. If
+ * memory runs out, some hits may go unrecorded. Turning recording off frees
+ * the list.
  *
- * #### Return Value
- * The current hit handler.
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `record`: Nonzero to record contacts, or 0 to stop.
  */
-jwb_hit_handler_t jwb_world_get_hit_handler(jwb_world_t *world);
+void jwb_world_record_contacts(jwb_world_t *world, int record);
 
 /**
- * ### `jwb_world_on_hit`
+ * ### `jwb_world_contacts`
  * ```
- * void jwb_world_on_hit(jwb_world_t *world, jwb_hit_handler_t on_hit);
+ * const struct jwb_contact *jwb_world_contacts(
+ *   jwb_world_t *world,
+ *   size_t *count);
  * ```
  *
- * Set the hit handler.
+ * Get the contacts recorded during the last step. The list is not copied. It
+ * is only valid until the next step, compaction, or change to recording.
+ * Compaction empties the list, since it changes handles.
  *
  * #### Parameters
- *  1. `world`: The world to change.
- *  2. `on_hit`: The new hit handler.
+ *  1. `world`: The world to look in.
+ *  2. `count`: Where to put the number of contacts.
+ *
+ * #### Return Value
+ * The recorded contacts, in the order in which the hits happened.
  */
-void jwb_world_on_hit(jwb_world_t *world, jwb_hit_handler_t on_hit);
+const struct jwb_contact *jwb_world_contacts(
+	jwb_world_t *world,
+	size_t *count);
 
 /**
  * ### `jwb_world_extra_size`
@@ -902,6 +2317,22 @@ void jwb_world_on_hit(jwb_world_t *world, jwb_hit_handler_t on_hit);
  */
 size_t jwb_world_extra_size(jwb_world_t *world);
 
+/**
+ * ### `jwb_world_handle_count`
+ * ```
+ * size_t jwb_world_handle_count(jwb_world_t *world);
+ * ```
+ *
+ * Get the number of handles in use by living, removed, and destroyed entities.
+ * All handles are less than this.
+ *
+ * #### Parameters
+ *  1. `world`: The world to examine.
+ * #### Return Value
+ * The number of handles.
+ */
+size_t jwb_world_handle_count(jwb_world_t *world);
+
 /**
  * ### `jwb_world_offset`
  * ```
@@ -962,6 +2393,156 @@ int jwb_world_track(jwb_world_t *world, jwb_ehandle_t ent);
  */
 jwb_ehandle_t jwb_world_tracking(jwb_world_t *world);
 
+/**
+ * ### `jwb_world_set_gravity`
+ * ```
+ * int jwb_world_set_gravity(jwb_world_t *world, const struct jwb_vect *accel);
+ * ```
+ *
+ * Set a constant acceleration which is applied to every entity as it moves
+ * during each step. The default is zero.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `accel`: The acceleration per unit of time.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_INVALID_ARGUMENT`: `accel` was `NULL`.
+ */
+int jwb_world_set_gravity(jwb_world_t *world, const struct jwb_vect *accel);
+
+/**
+ * ### `jwb_world_get_gravity`
+ * ```
+ * int jwb_world_get_gravity(jwb_world_t *world, struct jwb_vect *dest);
+ * ```
+ *
+ * Check the constant acceleration of the world.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *  2. `dest`: The place to put the current acceleration.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_INVALID_ARGUMENT`: `dest` was `NULL`.
+ */
+int jwb_world_get_gravity(jwb_world_t *world, struct jwb_vect *dest);
+
+/**
+ * ### `jwb_world_set_friction`
+ * ```
+ * int jwb_world_set_friction(jwb_world_t *world, jwb_num_t friction);
+ * ```
+ *
+ * Set the friction applied to every entity as it moves during each step. This
+ * has the same effect as calling `jwb_world_apply_friction_dt` after each step,
+ * but does not need another pass over the entities. The default is zero.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `friction`: The frictional acceleration per unit of time. Must not be
+ *     negative.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_INVALID_ARGUMENT`: `friction` was negative. The friction is not
+ *    changed.
+ */
+int jwb_world_set_friction(jwb_world_t *world, jwb_num_t friction);
+
+/**
+ * ### `jwb_world_get_friction`
+ * ```
+ * jwb_num_t jwb_world_get_friction(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The friction of the world.
+ */
+jwb_num_t jwb_world_get_friction(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_set_damping`
+ * ```
+ * int jwb_world_set_damping(jwb_world_t *world, jwb_num_t damping);
+ * ```
+ *
+ * Set the linear damping of the world. Each step, every velocity is scaled by
+ * `1 - damping * dt`, or zeroed if that is negative. The default is zero.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `damping`: The fraction of velocity lost per unit of time. Must not be
+ *     negative.
+ *
+ * #### Return Value
+ *  * `0`: Success.
+ *  * `-JWBE_INVALID_ARGUMENT`: `damping` was negative. The damping is not
+ *    changed.
+ */
+int jwb_world_set_damping(jwb_world_t *world, jwb_num_t damping);
+
+/**
+ * ### `jwb_world_get_damping`
+ * ```
+ * jwb_num_t jwb_world_get_damping(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The linear damping of the world.
+ */
+jwb_num_t jwb_world_get_damping(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_get_cell_size`
+ * ```
+ * jwb_num_t jwb_world_get_cell_size(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The size of the world's cells.
+ */
+jwb_num_t jwb_world_get_cell_size(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_get_width`
+ * ```
+ * size_t jwb_world_get_width(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The width of the world in cells.
+ */
+size_t jwb_world_get_width(jwb_world_t *world);
+
+/**
+ * ### `jwb_world_get_height`
+ * ```
+ * size_t jwb_world_get_height(jwb_world_t *world);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *
+ * #### Return Value
+ * The height of the world in cells.
+ */
+size_t jwb_world_get_height(jwb_world_t *world);
+
 /**
  * ### `jwb_world_get_pos`
  * ```
@@ -1396,15 +2977,262 @@ void jwb_world_set_radius_unck(
 	jwb_ehandle_t ent,
 	jwb_num_t radius);
 
+/**
+ * ### `jwb_world_set_filter`
+ * ```
+ * int jwb_world_set_filter(
+ *   jwb_world_t *world,
+ *   jwb_ehandle_t ent,
+ *   unsigned category,
+ *   unsigned mask);
+ * ```
+ *
+ * Set which entities an entity can hit. Two entities can only hit each other if
+ * the category of each has a bit in common with the mask of the other. This is
+ * checked before anything else about the pair, so filtered pairs cost very
+ * little. New entities have the category 1 and a mask with all bits set, so
+ * they hit everything. Only the low 16 bits are portable.
+ *
+ * With the flag `JWBF_CELL_FILTERS`, the filters in each cell are combined at
+ * the start of each step. Changes made to filters during a step might not
+ * take effect until the next step.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `ent`: The entity to change.
+ *  3. `category`: The bits saying what the entity is.
+ *  4. `mask`: The bits saying which categories the entity can hit.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_DESTROYED_ENTITY`: The entity was destroyed.
+ */
+int jwb_world_set_filter(
+	jwb_world_t *world,
+	jwb_ehandle_t ent,
+	unsigned category,
+	unsigned mask);
+
+/**
+ * ### `jwb_world_set_filter_unck`
+ * ```
+ * void jwb_world_set_filter_unck(
+ *   jwb_world_t *world,
+ *   jwb_ehandle_t ent,
+ *   unsigned category,
+ *   unsigned mask);
+ * ```
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `ent`: The entity to change.
+ *  3. `category`: The bits saying what the entity is.
+ *  4. `mask`: The bits saying which categories the entity can hit.
+ */
+void jwb_world_set_filter_unck(
+	jwb_world_t *world,
+	jwb_ehandle_t ent,
+	unsigned category,
+	unsigned mask);
+
+/**
+ * ### `jwb_world_get_filter`
+ * ```
+ * int jwb_world_get_filter(
+ *   jwb_world_t *world,
+ *   jwb_ehandle_t ent,
+ *   unsigned *category,
+ *   unsigned *mask);
+ * ```
+ *
+ * Get the collision filter of an entity. See `jwb_world_set_filter`.
+ *
+ * #### Parameters
+ *  1. `world`: The world to look in.
+ *  2. `ent`: The entity to look at.
+ *  3. `category`: Where to put the category, or `NULL`.
+ *  4. `mask`: Where to put the mask, or `NULL`.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_DESTROYED_ENTITY`: The entity was destroyed.
+ */
+int jwb_world_get_filter(
+	jwb_world_t *world,
+	jwb_ehandle_t ent,
+	unsigned *category,
+	unsigned *mask);
+
+/**
+ * ### `JWBX_POS`, `JWBX_VEL`, `JWBX_RADIUS`, `JWBX_MASS`
+ * ```
+ * #define JWBX_POS ...
+ * #define JWBX_VEL ...
+ * #define JWBX_RADIUS ...
+ * #define JWBX_MASS ...
+ * ```
+ *
+ * Fields which can be combined with `|` to choose what `jwb_world_export` and
+ * the like copy. Each record holds the chosen fields as `jwb_num_t`s in the
+ * order above. Positions and velocities are two numbers, x then y.
+ */
+#define JWBX_POS (1 << 0)
+#define JWBX_VEL (1 << 1)
+#define JWBX_RADIUS (1 << 2)
+#define JWBX_MASS (1 << 3)
+
+/**
+ * ### `jwb_world_export`
+ * ```
+ * size_t jwb_world_export(
+ *   jwb_world_t *world,
+ *   int fields,
+ *   void *dst,
+ *   size_t stride,
+ *   jwb_ehandle_t *handles_out);
+ * ```
+ *
+ * Copy fields of all living entities into records in one pass, such as for
+ * uploading instance data to a renderer. This is much faster than calling the
+ * getters for each entity. The entities are in the same order as given by
+ * `jwb_world_living` until any are added or removed.
+ *
+ * #### Parameters
+ *  1. `world`: The world to copy from.
+ *  2. `fields`: Which fields to copy. See `JWBX_POS`.
+ *  3. `dst`: Where to put the records, with room for one per living entity.
+ *     Each record must be aligned for `jwb_num_t`. May be `NULL` to only count
+ *     the entities or get their handles.
+ *  4. `stride`: The number of bytes from the start of one record to the start
+ *     of the next, or 0 if the records are packed together. Bytes of a record
+ *     not used by the fields are left alone.
+ *  5. `handles_out`: Where to put the handle of each record, with room for
+ *     one per living entity, or `NULL`.
+ *
+ * #### Return Value
+ * The number of living entities, which is the number of records written.
+ */
+size_t jwb_world_export(
+	jwb_world_t *world,
+	int fields,
+	void *dst,
+	size_t stride,
+	jwb_ehandle_t *handles_out);
+
+/**
+ * ### `jwb_world_export_list`
+ * ```
+ * void jwb_world_export_list(
+ *   jwb_world_t *world,
+ *   int fields,
+ *   const jwb_ehandle_t *handles,
+ *   size_t n_handles,
+ *   void *dst,
+ *   size_t stride);
+ * ```
+ *
+ * Copy fields of the listed entities into records, as in `jwb_world_export`.
+ * The handles are not checked, so none may be destroyed.
+ *
+ * #### Parameters
+ *  1. `world`: The world to copy from.
+ *  2. `fields`: Which fields to copy. See `JWBX_POS`.
+ *  3. `handles`: The entities to copy.
+ *  4. `n_handles`: The number of entities in `handles`.
+ *  5. `dst`: Where to put the records, with room for `n_handles` of them.
+ *  6. `stride`: The number of bytes between records, or 0 if they are packed.
+ */
+void jwb_world_export_list(
+	jwb_world_t *world,
+	int fields,
+	const jwb_ehandle_t *handles,
+	size_t n_handles,
+	void *dst,
+	size_t stride);
+
+/**
+ * ### `jwb_world_import`
+ * ```
+ * int jwb_world_import(
+ *   jwb_world_t *world,
+ *   int fields,
+ *   const void *src,
+ *   size_t stride,
+ *   const jwb_ehandle_t *handles,
+ *   size_t n_handles);
+ * ```
+ *
+ * Set the positions or velocities of many entities from records laid out as
+ * by `jwb_world_export`. The handles are not checked, so none may be
+ * destroyed. Moved entities are put in the right cells in the next step.
+ *
+ * #### Parameters
+ *  1. `world`: The world to change.
+ *  2. `fields`: Which fields the records hold. Only `JWBX_POS` and `JWBX_VEL`
+ *     can be given.
+ *  3. `src`: The records.
+ *  4. `stride`: The number of bytes between records, or 0 if they are packed.
+ *  5. `handles`: The entity of each record, or `NULL` for the living entities
+ *     in the order given by `jwb_world_export`.
+ *  6. `n_handles`: The number of records. If `handles` is `NULL`, this must be
+ *     the number of living entities.
+ *
+ * #### Return Value
+ * 0 on success, or a negative error code.
+ *
+ * #### Errors
+ *  * `-JWBE_INVALID_ARGUMENT`: `src` was `NULL`, `fields` had fields which
+ *    cannot be set, or `n_handles` did not match the living entities.
+ */
+int jwb_world_import(
+	jwb_world_t *world,
+	int fields,
+	const void *src,
+	size_t stride,
+	const jwb_ehandle_t *handles,
+	size_t n_handles);
+
 #ifdef JWB_INTERNAL_
 /* Internal type name shortcuts, macros, and flags. */
 
 typedef jwb_world_t WORLD;
 typedef struct jwb_vect VECT;
 typedef jwb_ehandle_t EHANDLE;
+#	ifdef JWBO_HANDLE_32
+#		define EHANDLE_MAX INT_MAX
+#	else
+#		define EHANDLE_MAX LONG_MAX
+#	endif
 
-#	define GET(world, ent) (*(struct jwb__entity *)&((world)->ents[(ent) \
-			* (world)->ent_size]))
+#	ifdef JWBO_PAGED_ENTS
+#		define PAGE_SHIFT 10
+#		define PAGE_ENTS ((size_t)1 << PAGE_SHIFT)
+#		define GET(world, ent) (*(struct jwb__entity *) \
+			&((world)->ents[(ent) >> PAGE_SHIFT][((ent) \
+			& (PAGE_ENTS - 1)) * (world)->ent_size]))
+/* Each page has its entities' out-of-line extra data, then its part of the
+ * dense list, after its entities. */
+#		define EXTRA(world, ent) ((world)->ents[(ent) >> PAGE_SHIFT] \
+			+ PAGE_ENTS * (world)->ent_size \
+			+ ((ent) & (PAGE_ENTS - 1)) * (world)->extra_size)
+#		define ALIVE(world, i) (((EHANDLE *)((world)->ents[(i) \
+			>> PAGE_SHIFT] + PAGE_ENTS * ((world)->ent_size \
+			+ (world)->extra_size)))[(i) & (PAGE_ENTS - 1)])
+#	else
+#		define GET(world, ent) (*(struct jwb__entity *) \
+			&((world)->ents[(ent) * (world)->ent_size]))
+#		define EXTRA(world, ent) \
+			((world)->extras + (ent) * (world)->extra_size)
+#		define ALIVE(world, i) ((world)->alive[(i)])
+#	endif
+
+/* The space taken in the entity buffer by each entity. */
+#	define SLOT_SIZE(world) \
+		((world)->ent_size + (world)->extra_size + sizeof(EHANDLE))
 
 #	ifdef JWBO_ALWAYS_REMOVE_DISTANT
 #		define REMOVING_DISTANT(world) ((void)(world), 1)
@@ -1415,17 +3243,107 @@ typedef jwb_ehandle_t EHANDLE;
 			((world)->flags & JWBF_REMOVE_DISTANT)
 #	endif
 
+#	define WALLED(world) ((world)->flags & JWBF_WALLED)
+
+/* Arithmetic on two numbers. NUM converts constants. */
+#	define NUM(x) JWB_NUM(x)
+#	ifdef JWBO_NUM_FIXED
+#		define MUL(a, b) ((jwb_num_t)(((a) * (b)) >> 16))
+#		define DIV(a, b) ((jwb_num_t)((a) * 65536L / (b)))
+#		define SQRT(a) jwb__fixed_sqrt((a))
+/* Get the square root of a fixed-point number using only integer arithmetic.
+ * Defined in vect.c. */
+jwb_num_t jwb__fixed_sqrt(jwb_num_t num);
+#	else
+#		define MUL(a, b) ((a) * (b))
+#		define DIV(a, b) ((a) / (b))
+#		define SQRT(a) sqrt((a))
+#	endif
+
+#	define TRACKING_CONTACTS(world) \
+		((world)->on_contact_begin || (world)->on_contact_end)
+
 #	ifdef JWBO_NO_ALLOC
-#		define ALLOC(size) ((void)(size), NULL)
-#		define FREE(ptr) ((void)(ptr))
+#		define ALLOC(world, size) ((void)(world), (void)(size), NULL)
+#		define REALLOC(world, ptr, size) \
+			((void)(world), (void)(ptr), (void)(size), NULL)
+#		define FREE(world, ptr) ((void)(world), (void)(ptr))
 #	else
-#		define ALLOC(size) malloc((size))
-#		define FREE(ptr) free((ptr))
+#		define ALLOC(world, size) \
+			(world)->allocator.alloc((world)->allocator.ctx, (size))
+#		define REALLOC(world, ptr, size) (world)->allocator.realloc( \
+			(world)->allocator.ctx, (ptr), (size))
+#		define FREE(world, ptr) \
+			(world)->allocator.free((world)->allocator.ctx, (ptr))
 #	endif /* JWBO_NO_ALLOC */
 
 /* Private flags for WORLD::flags */
 #	define ONE_CELL_THICK (1 << 1)
 #	define PROVIDED_ENT_BUF (1 << 2)
+#	define PROVIDED_CELL_BUF (1 << 4)
+
+#	ifdef JWBO_PAGED_ENTS
+/* Add one page of entities, increasing the capacity by PAGE_ENTS. Defined in
+ * world-alloc.c. */
+int jwb__add_page(WORLD *world);
+#	endif
+
+/* Put a number inside the range [0, lim). jwb__fframe(12, 5) is 2, while
+ * jwb__fframe(-12, 5) is 3. Defined in world-sim.c. */
+jwb_num_t jwb__fframe(jwb_num_t num, jwb_num_t lim);
+
+/* Make room for at least `cap` entities in all, growing the buffer by at least
+ * half. Returns JWBE_NO_MEMORY on failure. Defined in world-alloc.c. */
+int jwb__reserve_ents(WORLD *world, size_t cap);
+
+/* Get the bytes allocated for the long-range force tree. Defined in
+ * world-forces.c. */
+size_t jwb__tree_memory(WORLD *world);
+
+/* Get the bytes allocated for the contact table. Defined in
+ * world-contacts.c. */
+size_t jwb__contacts_memory(WORLD *world);
+
+/* Make the contact table as small as it can be, freeing it if it is empty.
+ * Defined in world-contacts.c. */
+void jwb__shrink_contacts(WORLD *world);
+
+/* Record that two entities are touching this step. Defined in
+ * world-contacts.c. */
+void jwb__touch_contact(WORLD *world, EHANDLE ent1, EHANDLE ent2);
+
+/* Add a hit to the list of recorded contacts, growing it if needed. Defined in
+ * world-contacts.c. */
+void jwb__record_contact(WORLD *world, EHANDLE ent1, EHANDLE ent2,
+	const struct jwb_hit_info *info, jwb_num_t impulse);
+
+/* Forget contacts which were not touched this step, calling the end handler.
+ * Defined in world-contacts.c. */
+void jwb__end_contacts(WORLD *world);
+
+/* Change the handles in the contact table to the new ones assigned during
+ * compaction, forgetting contacts with destroyed entities. Defined in
+ * world-contacts.c. */
+void jwb__remap_contacts(WORLD *world);
+
+#	ifndef JWBO_NO_ALLOC
+/* The allocator used when none is given. Defined in world-alloc.c. */
+extern const struct jwb_allocator jwb__default_allocator;
+#	endif
+
+/* Write a frame of the recording at the end of a step. Defined in
+ * world-record.c. */
+void jwb__record_frame(WORLD *world);
+
+/* Make the next recorded frame a key frame, such as after the handles change.
+ * Defined in world-record.c. */
+void jwb__restart_frames(WORLD *world);
+
+/* Get the bytes allocated for recording. Defined in world-record.c. */
+size_t jwb__recorder_memory(WORLD *world);
+
+/* Stop recording, freeing the recording state. Defined in world-record.c. */
+void jwb__free_recorder(WORLD *world);
 
 /* Private flags for jwb__entity::flags */
 #	define REMOVED (1 << 0)
@@ -15,6 +15,12 @@ const char *jwb_errmsg(int code)
 		return "Entity handle referenced a destroyed entity (CRITICAL)";
 	case JWBE_INVALID_ARGUMENT:
 		return "Invalid argument";
+	case JWBE_IO:
+		return "Reading or writing a file failed";
+	case JWBE_BAD_SNAPSHOT:
+		return "Snapshot is damaged or from an incompatible build";
+	case JWBE_BAD_RECORDING:
+		return "Recording is damaged";
 	case 0:
 		return "No error";
 	default:
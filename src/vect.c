@@ -4,13 +4,13 @@
 
 void jwb_rotation(jwb_rotation_t *rot, jwb_num_t angle)
 {
-	rot->sin = sin(angle);
-	rot->cos = cos(angle);
+	rot->sin = JWB_NUM(sin(JWB_NUM_TO_DOUBLE(angle)));
+	rot->cos = JWB_NUM(cos(JWB_NUM_TO_DOUBLE(angle)));
 }
 
 jwb_num_t jwb_rotation_angle(const jwb_rotation_t *rot)
 {
-	return atan2(rot->sin, rot->cos);
+	return JWB_NUM(atan2(rot->sin, rot->cos));
 }
 
 void jwb_rotation_flip(jwb_rotation_t *rot)
@@ -22,30 +22,66 @@ void jwb_rotation_flip(jwb_rotation_t *rot)
 void jwb_vect_rotate(struct jwb_vect *vect, const jwb_rotation_t *rot)
 {
 	jwb_num_t x = vect->x;
-	vect->x = x * rot->cos - vect->y * rot->sin;
-	vect->y = x * rot->sin + vect->y * rot->cos;
+	vect->x = MUL(x, rot->cos) - MUL(vect->y, rot->sin);
+	vect->y = MUL(x, rot->sin) + MUL(vect->y, rot->cos);
 }
 
+#ifdef JWBO_NUM_FIXED
+jwb_num_t jwb__fixed_sqrt(jwb_num_t num)
+{
+	/* The root of the raw number times 65536 is the raw root. This finds it
+	 * one bit at a time. */
+	unsigned long rem, root, bit;
+	if (num <= 0) {
+		return 0;
+	}
+	rem = (unsigned long)num << 16;
+	root = 0;
+	bit = 1UL << 62;
+	while (bit > rem) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (rem >= root + bit) {
+			rem -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+#endif /* JWBO_NUM_FIXED */
+
 jwb_num_t jwb_vect_magnitude(const struct jwb_vect *vect)
 {
-	return sqrt(vect->x * vect->x + vect->y * vect->y);
+	return SQRT(MUL(vect->x, vect->x) + MUL(vect->y, vect->y));
 }
 
 void jwb_vect_normalize(struct jwb_vect *vect)
 {
 	jwb_num_t mag = jwb_vect_magnitude(vect);
-	vect->x /= mag;
-	vect->y /= mag;
+	if (mag == 0) {
+		return;
+	}
+	vect->x = DIV(vect->x, mag);
+	vect->y = DIV(vect->y, mag);
 }
 
 jwb_num_t jwb_vect_angle(const struct jwb_vect *vect)
 {
-	return atan2(vect->y, vect->x);
+	return JWB_NUM(atan2(vect->y, vect->x));
 }
 
 void jwb_vect_rotation(const struct jwb_vect *vect, jwb_rotation_t *rot)
 {
 	jwb_num_t mag = jwb_vect_magnitude(vect);
-	rot->sin = vect->y / mag;
-	rot->cos = vect->x / mag;
+	if (mag == 0) {
+		rot->sin = 0;
+		rot->cos = JWB_NUM(1.);
+		return;
+	}
+	rot->sin = DIV(vect->y, mag);
+	rot->cos = DIV(vect->x, mag);
 }
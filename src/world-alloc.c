@@ -3,14 +3,237 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef JWBO_NO_ALLOC
+/* The allocator used when none is given. */
+static void *default_alloc(void *ctx, size_t size)
+{
+	(void)ctx;
+	return malloc(size);
+}
+
+static void *default_realloc(void *ctx, void *ptr, size_t size)
+{
+	(void)ctx;
+	return realloc(ptr, size);
+}
+
+static void default_free(void *ctx, void *ptr)
+{
+	(void)ctx;
+	free(ptr);
+}
+
+const struct jwb_allocator jwb__default_allocator = {
+	default_alloc,
+	default_realloc,
+	default_free,
+	NULL
+};
+#endif /* JWBO_NO_ALLOC */
+
+#ifdef JWBO_PAGED_ENTS
+int jwb__add_page(WORLD *world)
+{
+	size_t n_pages = world->ent_cap / PAGE_ENTS;
+	char *page;
+	if (n_pages >= world->dir_cap) {
+		size_t new_cap = world->dir_cap * 2 + 1;
+		char **new_dir = REALLOC(world, world->ents,
+			new_cap * sizeof(*new_dir));
+		if (!new_dir) {
+			return -JWBE_NO_MEMORY;
+		}
+		world->ents = new_dir;
+		world->dir_cap = new_cap;
+	}
+	page = ALLOC(world, PAGE_ENTS * SLOT_SIZE(world));
+	if (!page) {
+		return -JWBE_NO_MEMORY;
+	}
+	world->ents[n_pages] = page;
+	world->ent_cap += PAGE_ENTS;
+	return 0;
+}
+
+/* Free pages from the end until there are only `n_pages` left. */
+static void free_pages_after(WORLD *world, size_t n_pages)
+{
+	while (world->ent_cap / PAGE_ENTS > n_pages) {
+		world->ent_cap -= PAGE_ENTS;
+		FREE(world, world->ents[world->ent_cap / PAGE_ENTS]);
+	}
+}
+
+/* Free all pages and the page directory. */
+static void free_pages(WORLD *world)
+{
+	free_pages_after(world, 0);
+	FREE(world, world->ents);
+}
+#endif /* JWBO_PAGED_ENTS */
+
+#if !defined(JWBO_NO_ALLOC) && !defined(JWBO_PAGED_ENTS)
+/* Move the out-of-line extra data and the dense list, which come after the
+ * entities, for a buffer whose capacity is changing. */
+static void move_tails(WORLD *world, char *buf, size_t old_cap, size_t new_cap)
+{
+	char *old_extras, *old_alive;
+	size_t extras_size, alive_size;
+	old_extras = buf + old_cap * world->ent_size;
+	old_alive = old_extras + old_cap * world->extra_size;
+	extras_size = world->n_ents * world->extra_size;
+	alive_size = world->n_alive * sizeof(EHANDLE);
+	world->extras = buf + new_cap * world->ent_size;
+	world->alive = (EHANDLE *)(world->extras
+		+ new_cap * world->extra_size);
+	/* Move whichever would be overwritten by the other first. */
+	if (new_cap > old_cap) {
+		memmove(world->alive, old_alive, alive_size);
+		memmove(world->extras, old_extras, extras_size);
+	} else {
+		memmove(world->extras, old_extras, extras_size);
+		memmove(world->alive, old_alive, alive_size);
+	}
+}
+#endif
+
+/* Change the capacity of the entity buffer to at least `new_cap`, which must
+ * not be less than the number of handles in use. Returns JWBE_NO_MEMORY on
+ * memory failures. */
+static int resize_ents(WORLD *world, size_t new_cap)
+{
+#ifdef JWBO_NO_ALLOC
+	return new_cap <= world->ent_cap ? 0 : -JWBE_NO_MEMORY;
+#elif defined(JWBO_PAGED_ENTS)
+	size_t n_pages = (new_cap + PAGE_ENTS - 1) / PAGE_ENTS;
+	while (world->ent_cap / PAGE_ENTS < n_pages) {
+		if (jwb__add_page(world)) {
+			return -JWBE_NO_MEMORY;
+		}
+	}
+	free_pages_after(world, n_pages);
+	return 0;
+#else
+	char *new_buf;
+	if (world->flags & PROVIDED_ENT_BUF) {
+		return new_cap <= world->ent_cap ? 0 : -JWBE_NO_MEMORY;
+	}
+	if (new_cap == 0) {
+		/* Zero-size reallocation might free the buffer. */
+		new_cap = 1;
+	}
+	if (new_cap < world->ent_cap) {
+		move_tails(world, world->ents, world->ent_cap, new_cap);
+		world->ent_cap = new_cap;
+		/* If shrinking fails, the old buffer is still good. */
+		new_buf = REALLOC(world, world->ents,
+			new_cap * SLOT_SIZE(world));
+		if (new_buf) {
+			/* Nothing moves, but the pointers are updated. */
+			world->ents = new_buf;
+			move_tails(world, new_buf, new_cap, new_cap);
+		}
+	} else if (new_cap > world->ent_cap) {
+		new_buf = REALLOC(world, world->ents,
+			new_cap * SLOT_SIZE(world));
+		if (!new_buf) {
+			return -JWBE_NO_MEMORY;
+		}
+		move_tails(world, new_buf, world->ent_cap, new_cap);
+		world->ents = new_buf;
+		world->ent_cap = new_cap;
+	}
+	return 0;
+#endif /* JWBO_NO_ALLOC */
+}
+
+int jwb__reserve_ents(WORLD *world, size_t cap)
+{
+	size_t new_cap;
+	if (cap <= world->ent_cap) {
+		return 0;
+	}
+	if (cap > (size_t)EHANDLE_MAX) {
+		return -JWBE_NO_MEMORY;
+	}
+#ifdef JWBO_PAGED_ENTS
+	/* Pages are added one at a time anyway. */
+	new_cap = cap;
+#else
+	/* Grow by at least half so that adding one at a time takes amortized
+	 * constant time. */
+	new_cap = world->ent_cap * 3 / 2 + 1;
+	if (new_cap < cap || new_cap > (size_t)EHANDLE_MAX) {
+		new_cap = cap;
+	}
+#endif
+	return resize_ents(world, new_cap);
+}
+
+int jwb_world_reserve(WORLD *world, size_t num)
+{
+	if (num <= world->ent_cap) {
+		return 0;
+	}
+	if (num > (size_t)EHANDLE_MAX) {
+		return -JWBE_NO_MEMORY;
+	}
+	return resize_ents(world, num);
+}
+
+void jwb_world_shrink_to_fit(WORLD *world)
+{
+	size_t n_cells = world->width * world->height;
+	resize_ents(world, world->n_ents);
+	if (!(world->flags & PROVIDED_CELL_BUF) && world->cell_cap > n_cells) {
+		EHANDLE *cells = REALLOC(world, world->cells,
+			n_cells * sizeof(*cells));
+		if (cells) {
+			world->cells = cells;
+			world->cell_cap = n_cells;
+		}
+	}
+	/* The tree and cell filters are rebuilt every time they are used. */
+	FREE(world, world->tree);
+	world->tree = NULL;
+	world->tree_cap = 0;
+	FREE(world, world->cell_filters);
+	world->cell_filters = NULL;
+	world->cell_filters_cap = 0;
+	world->cell_filtering = 0;
+	jwb__shrink_contacts(world);
+}
+
+size_t jwb_world_memory_usage(WORLD *world)
+{
+	size_t size = sizeof(*world);
+	size += world->cell_cap * sizeof(EHANDLE);
+	size += world->ent_cap * SLOT_SIZE(world);
+#ifdef JWBO_PAGED_ENTS
+	size += world->dir_cap * sizeof(*world->ents);
+#endif
+	size += world->cell_filters_cap * 2 * sizeof(*world->cell_filters);
+	size += jwb__tree_memory(world);
+	size += jwb__contacts_memory(world);
+	size += jwb__recorder_memory(world);
+	return size;
+}
+
 int jwb_world_alloc(WORLD *world, struct jwb_world_init *info)
 {
 	int ret = 0;
-	if (info->width == 0 || info->height == 0 || info->cell_size <= 0.) {
+	/* Cell indices must fit in handles, even after both sides are doubled for
+	 * worlds one cell thick. */
+	if (info->width == 0 || info->height == 0 || info->cell_size <= 0.
+	 || info->width > (size_t)EHANDLE_MAX / info->height / 4) {
 		ret = -JWBE_INVALID_ARGUMENT;
 		goto error_validity;
 	}
 	world->flags = info->flags;
+#ifndef JWBO_NO_ALLOC
+	world->allocator = info->allocator ? *info->allocator
+		: jwb__default_allocator;
+#endif
 	world->cell_size = info->cell_size;
 	world->width = info->width;
 	world->height = info->height;
@@ -18,42 +241,96 @@ int jwb_world_alloc(WORLD *world, struct jwb_world_init *info)
 		world->flags |= ONE_CELL_THICK;
 		world->width *= 2;
 		world->height *= 2;
-		world->cell_size /= 2.;
+		world->cell_size /= 2;
 	}
+	world->cell_cap = world->width * world->height;
 	if (info->cell_buf) {
-		world->flags |= PROVIDED_ENT_BUF;
+		world->flags |= PROVIDED_CELL_BUF;
 		world->cells = info->cell_buf;
 	} else {
 		size_t size = world->width * world->height * sizeof(EHANDLE);
-		world->cells = ALLOC(size);
+		world->cells = ALLOC(world, size);
 		if (!world->cells) {
 			ret = -JWBE_NO_MEMORY;
 			goto error_cells;
 		}
 		memset(world->cells, -1, size);
 	}
+	if (world->flags & JWBF_SEPARATE_EXTRA) {
+		world->ent_size = JWB__ENTITY_SIZE(0);
+		world->extra_size = JWB__ALIGN(info->ent_extra, 8);
+	} else {
+		world->ent_size = JWB__ENTITY_SIZE(info->ent_extra);
+		world->extra_size = 0;
+	}
+#ifdef JWBO_PAGED_ENTS
+	world->ent_cap = 0;
+	world->ents = NULL;
+	world->dir_cap = 0;
+	if (info->ent_buf) {
+		ret = -JWBE_INVALID_ARGUMENT;
+		goto error_entities;
+	}
+	while (world->ent_cap < info->ent_buf_size) {
+		if (jwb__add_page(world)) {
+			ret = -JWBE_NO_MEMORY;
+			goto error_entities;
+		}
+	}
+#else
 	world->ent_cap = info->ent_buf_size;
-	world->ent_size = JWB__ENTITY_SIZE(info->ent_extra);
 	if (info->ent_buf) {
+		world->flags |= PROVIDED_ENT_BUF;
 		world->ents = info->ent_buf;
 	} else {
-		world->ents = ALLOC(world->ent_cap * world->ent_size);
+		world->ents = ALLOC(world, world->ent_cap * SLOT_SIZE(world));
 		if (!world->ents) {
 			ret = -JWBE_NO_MEMORY;
 			goto error_entities;
 		}
 	}
+	/* Out-of-line extra data and then the dense list are stored after the
+	 * entities. */
+	world->extras = world->ents + world->ent_cap * world->ent_size;
+	world->alive = (EHANDLE *)(world->extras
+		+ world->ent_cap * world->extra_size);
+#endif /* JWBO_PAGED_ENTS */
+	world->n_alive = 0;
 	world->n_ents = 0;
 	world->on_hit = JWB_WORLD_DEFAULT_HIT_HANDLER;
 	world->freed = -1;
 	world->available = -1;
 	world->offset.x = world->offset.y = 0.;
+	world->gravity.x = world->gravity.y = 0.;
+	world->friction = 0.;
+	world->damping = 0.;
 	world->tracking = -1;
+	world->tree = NULL;
+	world->tree_cap = 0;
+	world->on_contact_begin = NULL;
+	world->on_contact_end = NULL;
+	world->contacts = NULL;
+	world->contacts_cap = 0;
+	world->n_contacts = 0;
+	world->contact_pass = 0;
+	world->recorded = NULL;
+	world->recorded_cap = 0;
+	world->n_recorded = 0;
+	world->recording = 0;
+	world->cell_filters = NULL;
+	world->cell_filters_cap = 0;
+	world->cell_filtering = 0;
+	world->recorder = NULL;
+	world->regrid_interval = 0;
+	world->regrid_countdown = 0;
 	return ret;
 
 error_entities:
+#ifdef JWBO_PAGED_ENTS
+	free_pages(world);
+#endif
 	if (!info->cell_buf) {
-		FREE(world->cells);
+		FREE(world, world->cells);
 	}
 error_cells:
 error_validity:
@@ -62,6 +339,19 @@ error_validity:
 
 void jwb_world_destroy(WORLD *world)
 {
-	FREE(world->cells);
-	FREE(world->ents);
+	if (!(world->flags & PROVIDED_CELL_BUF)) {
+		FREE(world, world->cells);
+	}
+#ifdef JWBO_PAGED_ENTS
+	free_pages(world);
+#else
+	if (!(world->flags & PROVIDED_ENT_BUF)) {
+		FREE(world, world->ents);
+	}
+#endif
+	FREE(world, world->tree);
+	FREE(world, world->contacts);
+	FREE(world, world->recorded);
+	FREE(world, world->cell_filters);
+	jwb__free_recorder(world);
 }
@@ -0,0 +1,273 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+#include <stdlib.h>
+
+/* An entry in the open-addressed contact table. The lesser handle is always
+ * first. Empty slots have ent1 set to -1. */
+struct contact {
+	EHANDLE ent1, ent2;
+	unsigned long pass; /* The collision pass in which they last touched. */
+};
+
+/* Get the slot where a pair would first be looked for. The capacity is always
+ * a power of two. */
+static size_t contact_hash(size_t cap, EHANDLE ent1, EHANDLE ent2)
+{
+	unsigned long hash;
+	hash = (unsigned long)ent1 * 2654435761UL;
+	hash ^= (unsigned long)ent2 + 0x9e3779b9UL + (hash << 6) + (hash >> 2);
+	return hash & (cap - 1);
+}
+
+/* Find the slot holding a pair, or the empty slot where it would go. */
+static struct contact *find_contact(WORLD *world, EHANDLE ent1, EHANDLE ent2)
+{
+	struct contact *table = world->contacts;
+	size_t i = contact_hash(world->contacts_cap, ent1, ent2);
+	while (table[i].ent1 >= 0
+	    && (table[i].ent1 != ent1 || table[i].ent2 != ent2)) {
+		i = (i + 1) & (world->contacts_cap - 1);
+	}
+	return &table[i];
+}
+
+/* Allocate an empty table. Returns NULL on memory failure. */
+static struct contact *alloc_table(WORLD *world, size_t cap)
+{
+	struct contact *table;
+	size_t i;
+	table = ALLOC(world, cap * sizeof(*table));
+	if (table) {
+		for (i = 0; i < cap; ++i) {
+			table[i].ent1 = -1;
+		}
+	}
+	return table;
+}
+
+/* Move the table into one of a new capacity, which must hold every entry. */
+static int rehash_contacts(WORLD *world, size_t new_cap)
+{
+	struct contact *old, *new_table;
+	size_t old_cap, i;
+	old = world->contacts;
+	old_cap = world->contacts_cap;
+	new_table = alloc_table(world, new_cap);
+	if (!new_table) {
+		return -JWBE_NO_MEMORY;
+	}
+	world->contacts = new_table;
+	world->contacts_cap = new_cap;
+	for (i = 0; i < old_cap; ++i) {
+		if (old[i].ent1 >= 0) {
+			*find_contact(world, old[i].ent1, old[i].ent2) = old[i];
+		}
+	}
+	FREE(world, old);
+	return 0;
+}
+
+/* Make the table twice as big, or allocate it if it did not exist. */
+static int grow_contacts(WORLD *world)
+{
+	size_t old_cap = world->contacts_cap;
+	return rehash_contacts(world, old_cap > 0 ? old_cap * 2 : 64);
+}
+
+/* Empty the slot at index i, shifting later entries of the same cluster back
+ * so that lookups still find them. */
+static void delete_contact(WORLD *world, size_t i)
+{
+	struct contact *table = world->contacts;
+	size_t mask = world->contacts_cap - 1;
+	size_t j = i;
+	for (;;) {
+		size_t home;
+		j = (j + 1) & mask;
+		if (table[j].ent1 < 0) {
+			break;
+		}
+		home = contact_hash(world->contacts_cap,
+			table[j].ent1, table[j].ent2);
+		/* Move the entry if its home is not cyclically in (i, j]. */
+		if (i <= j ? (i >= home || home > j) : (i >= home && home > j)) {
+			table[i] = table[j];
+			i = j;
+		}
+	}
+	table[i].ent1 = -1;
+	--world->n_contacts;
+}
+
+void jwb__shrink_contacts(WORLD *world)
+{
+	size_t new_cap;
+	if (world->n_recorded == 0) {
+		FREE(world, world->recorded);
+		world->recorded = NULL;
+		world->recorded_cap = 0;
+	} else if (world->n_recorded < world->recorded_cap) {
+		struct jwb_contact *recorded = REALLOC(world, world->recorded,
+			world->n_recorded * sizeof(*recorded));
+		if (recorded) {
+			world->recorded = recorded;
+			world->recorded_cap = world->n_recorded;
+		}
+	}
+	if (world->n_contacts == 0) {
+		FREE(world, world->contacts);
+		world->contacts = NULL;
+		world->contacts_cap = 0;
+		return;
+	}
+	/* Find the smallest capacity to which the table could have grown. */
+	for (new_cap = 64; world->n_contacts * 4 > new_cap * 3; new_cap *= 2)
+		;
+	if (new_cap < world->contacts_cap) {
+		/* On failure, the old table is kept. */
+		rehash_contacts(world, new_cap);
+	}
+}
+
+size_t jwb__contacts_memory(WORLD *world)
+{
+	return world->contacts_cap * sizeof(struct contact)
+		+ world->recorded_cap * sizeof(struct jwb_contact);
+}
+
+void jwb__touch_contact(WORLD *world, EHANDLE ent1, EHANDLE ent2)
+{
+	struct contact *contact;
+	if (ent1 > ent2) {
+		EHANDLE tmp = ent1;
+		ent1 = ent2;
+		ent2 = tmp;
+	}
+	if ((world->n_contacts + 1) * 4 > world->contacts_cap * 3
+	 && grow_contacts(world)) {
+		return;
+	}
+	contact = find_contact(world, ent1, ent2);
+	contact->pass = world->contact_pass;
+	if (contact->ent1 < 0) {
+		contact->ent1 = ent1;
+		contact->ent2 = ent2;
+		++world->n_contacts;
+		if (world->on_contact_begin) {
+			world->on_contact_begin(world, ent1, ent2);
+		}
+	}
+}
+
+void jwb__end_contacts(WORLD *world)
+{
+	size_t i = 0;
+	/* The handler might turn off tracking, so the table is looked up anew
+	 * each time. */
+	while (i < world->contacts_cap) {
+		struct contact *table = world->contacts;
+		if (table[i].ent1 >= 0 && table[i].pass != world->contact_pass) {
+			EHANDLE ent1 = table[i].ent1, ent2 = table[i].ent2;
+			/* Something else may be shifted into this slot. */
+			delete_contact(world, i);
+			if (world->on_contact_end) {
+				world->on_contact_end(world, ent1, ent2);
+			}
+		} else {
+			++i;
+		}
+	}
+	++world->contact_pass;
+}
+
+void jwb__remap_contacts(WORLD *world)
+{
+	/* The new handles of entities are in `last` during compaction. */
+	struct contact *old;
+	size_t old_cap, i;
+	old = world->contacts;
+	old_cap = world->contacts_cap;
+	world->contacts = alloc_table(world, old_cap);
+	world->n_contacts = 0;
+	if (!world->contacts) {
+		/* Forget everything rather than keep stale handles. */
+		world->contacts_cap = 0;
+		FREE(world, old);
+		return;
+	}
+	for (i = 0; i < old_cap; ++i) {
+		struct contact *contact;
+		EHANDLE ent1, ent2;
+		if (old[i].ent1 < 0
+		 || GET(world, old[i].ent1).flags & DESTROYED
+		 || GET(world, old[i].ent2).flags & DESTROYED) {
+			continue;
+		}
+		ent1 = GET(world, old[i].ent1).last;
+		ent2 = GET(world, old[i].ent2).last;
+		if (ent1 > ent2) {
+			EHANDLE tmp = ent1;
+			ent1 = ent2;
+			ent2 = tmp;
+		}
+		contact = find_contact(world, ent1, ent2);
+		contact->ent1 = ent1;
+		contact->ent2 = ent2;
+		contact->pass = old[i].pass;
+		++world->n_contacts;
+	}
+	FREE(world, old);
+}
+
+void jwb_world_on_contact(
+	WORLD *world,
+	jwb_contact_handler_t begin,
+	jwb_contact_handler_t end)
+{
+	world->on_contact_begin = begin;
+	world->on_contact_end = end;
+	if (!TRACKING_CONTACTS(world)) {
+		FREE(world, world->contacts);
+		world->contacts = NULL;
+		world->contacts_cap = 0;
+		world->n_contacts = 0;
+	}
+}
+
+void jwb__record_contact(WORLD *world, EHANDLE ent1, EHANDLE ent2,
+	const struct jwb_hit_info *info, jwb_num_t impulse)
+{
+	struct jwb_contact *contact;
+	if (world->n_recorded >= world->recorded_cap) {
+		size_t new_cap = world->recorded_cap * 2 + 64;
+		struct jwb_contact *recorded = REALLOC(world, world->recorded,
+			new_cap * sizeof(*recorded));
+		if (!recorded) {
+			return;
+		}
+		world->recorded = recorded;
+		world->recorded_cap = new_cap;
+	}
+	contact = &world->recorded[world->n_recorded++];
+	contact->ent1 = ent1;
+	contact->ent2 = ent2;
+	contact->info = *info;
+	contact->impulse = impulse;
+}
+
+void jwb_world_record_contacts(WORLD *world, int record)
+{
+	world->recording = record != 0;
+	world->n_recorded = 0;
+	if (!record) {
+		FREE(world, world->recorded);
+		world->recorded = NULL;
+		world->recorded_cap = 0;
+	}
+}
+
+const struct jwb_contact *jwb_world_contacts(WORLD *world, size_t *count)
+{
+	*count = world->n_recorded;
+	return world->recorded;
+}
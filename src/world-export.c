@@ -0,0 +1,132 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+
+/* The handle of the `i`th entity, from a list or from the living ones. */
+#define NTH(world, handles, i) ((handles) ? (handles)[i] : ALIVE(world, i))
+
+/* Get the size of a packed record holding some fields. */
+static size_t record_size(int fields)
+{
+	size_t n = 0;
+	n += fields & JWBX_POS ? 2 : 0;
+	n += fields & JWBX_VEL ? 2 : 0;
+	n += fields & JWBX_RADIUS ? 1 : 0;
+	n += fields & JWBX_MASS ? 1 : 0;
+	return n * sizeof(jwb_num_t);
+}
+
+/* Write fields of entities into records. Each field is copied in its own loop
+ * so that the loops stay simple. */
+static void export_ents(
+	WORLD *world,
+	int fields,
+	const EHANDLE *handles,
+	size_t n,
+	char *dst,
+	size_t stride)
+{
+	size_t i;
+	if (stride == 0) {
+		stride = record_size(fields);
+	}
+	if (fields & JWBX_POS) {
+		for (i = 0; i < n; ++i) {
+			jwb_num_t *rec = (jwb_num_t *)(dst + i * stride);
+			EHANDLE ent = NTH(world, handles, i);
+			rec[0] = GET(world, ent).pos.x;
+			rec[1] = GET(world, ent).pos.y;
+		}
+		dst += 2 * sizeof(jwb_num_t);
+	}
+	if (fields & JWBX_VEL) {
+		for (i = 0; i < n; ++i) {
+			jwb_num_t *rec = (jwb_num_t *)(dst + i * stride);
+			EHANDLE ent = NTH(world, handles, i);
+			rec[0] = GET(world, ent).vel.x;
+			rec[1] = GET(world, ent).vel.y;
+		}
+		dst += 2 * sizeof(jwb_num_t);
+	}
+	if (fields & JWBX_RADIUS) {
+		for (i = 0; i < n; ++i) {
+			*(jwb_num_t *)(dst + i * stride) =
+				GET(world, NTH(world, handles, i)).radius;
+		}
+		dst += sizeof(jwb_num_t);
+	}
+	if (fields & JWBX_MASS) {
+		for (i = 0; i < n; ++i) {
+			*(jwb_num_t *)(dst + i * stride) =
+				GET(world, NTH(world, handles, i)).mass;
+		}
+	}
+}
+
+size_t jwb_world_export(
+	WORLD *world,
+	int fields,
+	void *dst,
+	size_t stride,
+	EHANDLE *handles_out)
+{
+	size_t i;
+	if (dst) {
+		export_ents(world, fields, NULL, world->n_alive, dst, stride);
+	}
+	if (handles_out) {
+		for (i = 0; i < world->n_alive; ++i) {
+			handles_out[i] = ALIVE(world, i);
+		}
+	}
+	return world->n_alive;
+}
+
+void jwb_world_export_list(
+	WORLD *world,
+	int fields,
+	const EHANDLE *handles,
+	size_t n_handles,
+	void *dst,
+	size_t stride)
+{
+	export_ents(world, fields, handles, n_handles, dst, stride);
+}
+
+int jwb_world_import(
+	WORLD *world,
+	int fields,
+	const void *src,
+	size_t stride,
+	const EHANDLE *handles,
+	size_t n_handles)
+{
+	const char *from = src;
+	size_t i;
+	if (!src || fields & ~(JWBX_POS | JWBX_VEL)
+	 || (!handles && n_handles != world->n_alive)) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	if (stride == 0) {
+		stride = record_size(fields);
+	}
+	if (fields & JWBX_POS) {
+		for (i = 0; i < n_handles; ++i) {
+			const jwb_num_t *rec =
+				(const jwb_num_t *)(from + i * stride);
+			VECT *pos = &GET(world, NTH(world, handles, i)).pos;
+			pos->x = rec[0];
+			pos->y = rec[1];
+		}
+		from += 2 * sizeof(jwb_num_t);
+	}
+	if (fields & JWBX_VEL) {
+		for (i = 0; i < n_handles; ++i) {
+			const jwb_num_t *rec =
+				(const jwb_num_t *)(from + i * stride);
+			VECT *vel = &GET(world, NTH(world, handles, i)).vel;
+			vel->x = rec[0];
+			vel->y = rec[1];
+		}
+	}
+	return 0;
+}
@@ -1,13 +1,16 @@
 #define JWB_INTERNAL_
 #include <jwb.h>
 
+/* Living entities are visited from the end of the dense list back to the
+ * start. This way, removing the current entity only moves an entity which was
+ * already visited into its place. */
 static EHANDLE next(WORLD *world, EHANDLE now)
 {
-	do {
-		++now;
-	} while (now < (long)world->n_ents
-	    && GET(world, now).flags & (REMOVED | DESTROYED));
-	return now < (long)world->n_ents ? now : -1;
+	size_t idx = now >= 0 ? (size_t)GET(world, now).dense : world->n_alive;
+	if (idx > world->n_alive) {
+		idx = world->n_alive;
+	}
+	return idx > 0 ? ALIVE(world, idx - 1) : -1;
 }
 
 int jwb_world_first_perm(WORLD *world, EHANDLE *ent1, EHANDLE *ent2)
@@ -54,6 +57,31 @@ EHANDLE jwb_world_next(WORLD *world, EHANDLE now)
 	return now >= 0 ? next(world, now) : -1;
 }
 
+size_t jwb_world_living(
+	WORLD *world,
+	size_t start,
+	const EHANDLE **handles)
+{
+	size_t n;
+	if (start >= world->n_alive) {
+		return 0;
+	}
+	*handles = &ALIVE(world, start);
+	n = world->n_alive - start;
+#ifdef JWBO_PAGED_ENTS
+	/* The list is only contiguous within a page. */
+	if (n > PAGE_ENTS - (start & (PAGE_ENTS - 1))) {
+		n = PAGE_ENTS - (start & (PAGE_ENTS - 1));
+	}
+#endif
+	return n;
+}
+
+size_t jwb_world_living_count(WORLD *world)
+{
+	return world->n_alive;
+}
+
 EHANDLE jwb_world_first_removed(WORLD *world)
 {
 	return world->freed;
@@ -0,0 +1,334 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+#include <math.h>
+#include <stdlib.h>
+
+/* The deepest a node can be in the tree. Entities closer together than the
+ * size of the world divided by 2^MAX_DEPTH are lumped into one leaf. */
+#define MAX_DEPTH 32
+
+/* The `ent` of a leaf holding more than one entity. */
+#define MANY_ENTS (-2)
+
+/* A node of the quadtree. Children are stored four at a time. Within a group, bit
+ * 0 of the index is set for the upper half along x, and bit 1 along y. */
+struct node {
+	VECT center; /* Center of mass. Mass-weighted sum while building. */
+	jwb_num_t mass;
+	EHANDLE ent; /* For leaves, the contained entity, -1, or MANY_ENTS. */
+	long children; /* Index of the first child, or -1 for a leaf. */
+};
+
+/* Allocate four empty nodes at the end of the tree. Returns the index of the
+ * first one, or -JWBE_NO_MEMORY. */
+static long alloc_children(WORLD *world, size_t *n_nodes)
+{
+	struct node *nodes;
+	size_t i;
+	if (*n_nodes + 4 > world->tree_cap) {
+		size_t new_cap = world->tree_cap * 3 / 2 + 4;
+		nodes = REALLOC(world, world->tree,
+			new_cap * sizeof(*nodes));
+		if (!nodes) {
+			return -JWBE_NO_MEMORY;
+		}
+		world->tree = nodes;
+		world->tree_cap = new_cap;
+	}
+	nodes = world->tree;
+	for (i = *n_nodes; i < *n_nodes + 4; ++i) {
+		nodes[i].center.x = nodes[i].center.y = 0.;
+		nodes[i].mass = 0.;
+		nodes[i].ent = -1;
+		nodes[i].children = -1;
+	}
+	*n_nodes += 4;
+	return *n_nodes - 4;
+}
+
+/* Get which child of a node holds a position, given the node's center and half
+ * its side length. The center is moved to that of the child. */
+static int quadrant(const VECT *pos, VECT *center, jwb_num_t half)
+{
+	int quad = 0;
+	half /= 2;
+	if (pos->x < center->x) {
+		center->x -= half;
+	} else {
+		center->x += half;
+		quad |= 1;
+	}
+	if (pos->y < center->y) {
+		center->y -= half;
+	} else {
+		center->y += half;
+		quad |= 2;
+	}
+	return quad;
+}
+
+/* Get the position of an entity relative to the grid. */
+static void grid_pos(WORLD *world, EHANDLE ent, VECT *pos)
+{
+	pos->x = GET(world, ent).pos.x - world->offset.x;
+	pos->y = GET(world, ent).pos.y - world->offset.y;
+}
+
+/* Add an entity at a position (relative to the grid) to the tree. */
+static int insert(
+	WORLD *world,
+	size_t *n_nodes,
+	jwb_num_t side,
+	EHANDLE ent,
+	const VECT *pos,
+	jwb_num_t mass)
+{
+	VECT center;
+	jwb_num_t half;
+	long idx = 0;
+	int depth = 0;
+	center.x = center.y = half = side / 2;
+	for (;;) {
+		struct node *node = (struct node *)world->tree + idx;
+		if (node->children >= 0) {
+			node->center.x += MUL(pos->x, mass);
+			node->center.y += MUL(pos->y, mass);
+			node->mass += mass;
+			idx = node->children + quadrant(pos, &center, half);
+			half /= 2;
+			++depth;
+		} else if (node->ent == -1) {
+			node->center.x = MUL(pos->x, mass);
+			node->center.y = MUL(pos->y, mass);
+			node->mass = mass;
+			node->ent = ent;
+			return 0;
+		} else if (depth >= MAX_DEPTH) {
+			node->center.x += MUL(pos->x, mass);
+			node->center.y += MUL(pos->y, mass);
+			node->mass += mass;
+			node->ent = MANY_ENTS;
+			return 0;
+		} else {
+			/* Split the leaf, moving its occupant down a level. */
+			struct node *child;
+			VECT occupant, child_center;
+			long children = alloc_children(world, n_nodes);
+			if (children < 0) {
+				return children;
+			}
+			node = (struct node *)world->tree + idx;
+			/* Going by the occupant's own position rather than the
+			 * center of mass sends it down the same way as
+			 * `find_path` will. */
+			grid_pos(world, node->ent, &occupant);
+			child_center = center;
+			child = (struct node *)world->tree + children
+				+ quadrant(&occupant, &child_center, half);
+			*child = *node;
+			node->ent = -1;
+			node->children = children;
+		}
+	}
+}
+
+/* Turn the mass-weighted position sums into centers of mass. */
+static void finish_tree(WORLD *world, size_t n_nodes)
+{
+	struct node *nodes = world->tree;
+	size_t i;
+	for (i = 0; i < n_nodes; ++i) {
+		if (nodes[i].mass != 0.) {
+			nodes[i].center.x = DIV(nodes[i].center.x, nodes[i].mass);
+			nodes[i].center.y = DIV(nodes[i].center.y, nodes[i].mass);
+		}
+	}
+}
+
+/* Find the nodes from the root down to the leaf holding a position (relative
+ * to the grid.) Returns how many there are. */
+static int find_path(WORLD *world, jwb_num_t side, const VECT *pos, long *path)
+{
+	struct node *nodes = world->tree;
+	VECT center;
+	jwb_num_t half;
+	long idx = 0;
+	int n = 0;
+	center.x = center.y = half = side / 2;
+	for (;;) {
+		path[n++] = idx;
+		if (nodes[idx].children < 0) {
+			return n;
+		}
+		idx = nodes[idx].children + quadrant(pos, &center, half);
+		half /= 2;
+	}
+}
+
+/* Take the nearest copy of an offset along one axis of a world which wraps. */
+static jwb_num_t wrap_rel(jwb_num_t rel, jwb_num_t lim)
+{
+	return jwb__fframe(rel + lim / 2, lim) - lim / 2;
+}
+
+/* Whether a node with its center of mass at an offset `rel` (the nearest copy)
+ * lies wholly on one side of the seam halfway around a wrapping world. Every
+ * entity in the node is within `size` of that center along each axis. */
+static int clear_of_seam(const VECT *rel, jwb_num_t size, const VECT *lim)
+{
+	jwb_num_t x = rel->x < 0 ? -rel->x : rel->x;
+	jwb_num_t y = rel->y < 0 ? -rel->y : rel->y;
+	return x + size < lim->x / 2 && y + size < lim->y / 2;
+}
+
+/* Calculate the acceleration of an entity (not yet multiplied by strength.)
+ * `lim` is the size of the world if it wraps, or NULL. The entity is left out
+ * of the nodes which hold it, so it does not pull on itself when one of those
+ * is taken as a whole. */
+static void get_accel(
+	WORLD *world,
+	jwb_num_t side,
+	const VECT *lim,
+	const struct jwb_long_range *params,
+	EHANDLE ent,
+	const VECT *pos,
+	VECT *accel)
+{
+	struct {
+		long idx;
+		jwb_num_t size;
+		int level;
+	} stack[3 * MAX_DEPTH + 4];
+	long path[MAX_DEPTH + 1];
+	size_t depth = 1;
+	int n_path;
+	jwb_num_t soft2, theta2, own_mass;
+	struct node *nodes = world->tree;
+	soft2 = MUL(params->softening, params->softening);
+	theta2 = MUL(params->theta, params->theta);
+	own_mass = GET(world, ent).mass;
+	n_path = find_path(world, side, pos, path);
+	accel->x = accel->y = 0.;
+	stack[0].idx = 0;
+	stack[0].size = side;
+	stack[0].level = 0;
+	while (depth > 0) {
+		struct node *node;
+		VECT center, rel;
+		jwb_num_t mass, dist2, size;
+		int level;
+		--depth;
+		node = &nodes[stack[depth].idx];
+		size = stack[depth].size;
+		level = stack[depth].level;
+		if (node->mass == 0. || node->ent == ent) {
+			continue;
+		}
+		center = node->center;
+		mass = node->mass;
+		if (level < n_path && path[level] == stack[depth].idx) {
+			mass -= own_mass;
+			if (mass <= 0.) {
+				/* Nothing else is in here. */
+				continue;
+			}
+			center.x = DIV(MUL(node->center.x, node->mass)
+				- MUL(pos->x, own_mass), mass);
+			center.y = DIV(MUL(node->center.y, node->mass)
+				- MUL(pos->y, own_mass), mass);
+		}
+		rel.x = center.x - pos->x;
+		rel.y = center.y - pos->y;
+		if (lim) {
+			rel.x = wrap_rel(rel.x, lim->x);
+			rel.y = wrap_rel(rel.y, lim->y);
+		}
+		dist2 = MUL(rel.x, rel.x) + MUL(rel.y, rel.y) + soft2;
+		if (node->children < 0
+		 || (MUL(size, size) < MUL(theta2, dist2)
+		  && (!lim || clear_of_seam(&rel, size, lim)))) {
+			jwb_num_t scale;
+			if (dist2 == 0.) {
+				continue;
+			}
+			/* Dividing in two steps keeps fixed-point numbers in
+			 * range. */
+			scale = DIV(DIV(mass, SQRT(dist2)), dist2);
+			accel->x += MUL(rel.x, scale);
+			accel->y += MUL(rel.y, scale);
+		} else {
+			int i;
+			size /= 2;
+			for (i = 0; i < 4; ++i) {
+				stack[depth].idx = node->children + i;
+				stack[depth].size = size;
+				stack[depth].level = level + 1;
+				++depth;
+			}
+		}
+	}
+}
+
+size_t jwb__tree_memory(WORLD *world)
+{
+	return world->tree_cap * sizeof(struct node);
+}
+
+int jwb_world_apply_long_range(
+	WORLD *world,
+	const struct jwb_long_range *params,
+	jwb_num_t dt)
+{
+	struct node *root;
+	size_t n_nodes, cell, n_cells;
+	jwb_num_t side, scale;
+	VECT size;
+	const VECT *lim = NULL;
+	EHANDLE e;
+	if (params->theta < 0. || params->softening < 0.) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	side = world->width > world->height ? world->width : world->height;
+	side *= world->cell_size;
+	if (!REMOVING_DISTANT(world) && !WALLED(world)) {
+		size.x = (jwb_num_t)world->width * world->cell_size;
+		size.y = (jwb_num_t)world->height * world->cell_size;
+		lim = &size;
+	}
+	n_nodes = 0;
+	if (alloc_children(world, &n_nodes) < 0) {
+		return -JWBE_NO_MEMORY;
+	}
+	/* Only the first of the four is used as the root. */
+	n_nodes = 1;
+	n_cells = world->width * world->height;
+	for (cell = 0; cell < n_cells; ++cell) {
+		for (e = world->cells[cell]; e >= 0; e = GET(world, e).next) {
+			VECT pos;
+			int err;
+			grid_pos(world, e, &pos);
+			err = insert(world, &n_nodes, side, e, &pos,
+				GET(world, e).mass);
+			if (err < 0) {
+				return err;
+			}
+		}
+	}
+	finish_tree(world, n_nodes);
+	root = world->tree;
+	if (root->children < 0) {
+		/* There are no pairs of entities. */
+		return 0;
+	}
+	scale = MUL(params->strength, dt);
+	for (cell = 0; cell < n_cells; ++cell) {
+		for (e = world->cells[cell]; e >= 0; e = GET(world, e).next) {
+			VECT pos, accel;
+			grid_pos(world, e, &pos);
+			get_accel(world, side, lim, params, e, &pos, &accel);
+			GET(world, e).vel.x += MUL(accel.x, scale);
+			GET(world, e).vel.y += MUL(accel.y, scale);
+		}
+	}
+	return 0;
+}
@@ -13,10 +13,18 @@ void jwb_world_on_hit(WORLD *world, jwb_hit_handler_t on_hit)
 
 size_t jwb_world_extra_size(WORLD *world)
 {
+	if (world->flags & JWBF_SEPARATE_EXTRA) {
+		return world->extra_size;
+	}
 	return world->ent_size - JWB__ENTITY_SIZE(0) +
 		JWB__ENTITY_EXTRA_MIN_SIZE;
 }
 
+size_t jwb_world_handle_count(WORLD *world)
+{
+	return world->n_ents;
+}
+
 int jwb_world_offset(WORLD *world, const VECT *off)
 {
 	if (!off) {
@@ -53,6 +61,69 @@ EHANDLE jwb_world_tracking(WORLD *world)
 	return world->tracking;
 }
 
+int jwb_world_set_gravity(WORLD *world, const VECT *accel)
+{
+	if (!accel) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	world->gravity = *accel;
+	return 0;
+}
+
+int jwb_world_get_gravity(WORLD *world, VECT *dest)
+{
+	if (!dest) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	*dest = world->gravity;
+	return 0;
+}
+
+int jwb_world_set_friction(WORLD *world, jwb_num_t friction)
+{
+	if (friction < 0.) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	world->friction = friction;
+	return 0;
+}
+
+jwb_num_t jwb_world_get_friction(WORLD *world)
+{
+	return world->friction;
+}
+
+int jwb_world_set_damping(WORLD *world, jwb_num_t damping)
+{
+	if (damping < 0.) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	world->damping = damping;
+	return 0;
+}
+
+jwb_num_t jwb_world_get_damping(WORLD *world)
+{
+	return world->damping;
+}
+
+/* Worlds one cell thick are stored with twice as many cells on each side. */
+jwb_num_t jwb_world_get_cell_size(WORLD *world)
+{
+	return world->flags & ONE_CELL_THICK
+		? world->cell_size * 2 : world->cell_size;
+}
+
+size_t jwb_world_get_width(WORLD *world)
+{
+	return world->flags & ONE_CELL_THICK ? world->width / 2 : world->width;
+}
+
+size_t jwb_world_get_height(WORLD *world)
+{
+	return world->flags & ONE_CELL_THICK ? world->height / 2 : world->height;
+}
+
 #define VECT_METHOD(name, vtype, code) \
 	int jwb_world_##name(WORLD *world, EHANDLE ent, vtype *vect) \
 	{ \
@@ -142,6 +213,40 @@ SCALAR_SETTER(radius, v > world->cell_size, {
 	GET(world, ent).radius = v;
 })
 
+int jwb_world_set_filter(WORLD *world, EHANDLE ent, unsigned category,
+	unsigned mask)
+{
+	int err = jwb_world_confirm_ent(world, ent);
+	if (err == -JWBE_DESTROYED_ENTITY) {
+		return err;
+	}
+	jwb_world_set_filter_unck(world, ent, category, mask);
+	return 0;
+}
+
+void jwb_world_set_filter_unck(WORLD *world, EHANDLE ent, unsigned category,
+	unsigned mask)
+{
+	GET(world, ent).category = category;
+	GET(world, ent).mask = mask;
+}
+
+int jwb_world_get_filter(WORLD *world, EHANDLE ent, unsigned *category,
+	unsigned *mask)
+{
+	int err = jwb_world_confirm_ent(world, ent);
+	if (err == -JWBE_DESTROYED_ENTITY) {
+		return err;
+	}
+	if (category) {
+		*category = GET(world, ent).category;
+	}
+	if (mask) {
+		*mask = GET(world, ent).mask;
+	}
+	return 0;
+}
+
 void *jwb_world_get_extra(WORLD *world, EHANDLE ent)
 {
 	int err;
@@ -154,5 +259,8 @@ void *jwb_world_get_extra(WORLD *world, EHANDLE ent)
 
 void *jwb_world_get_extra_unck(WORLD *world, EHANDLE ent)
 {
+	if (world->flags & JWBF_SEPARATE_EXTRA) {
+		return EXTRA(world, ent);
+	}
 	return GET(world, ent).extra;
 }
@@ -0,0 +1,826 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+#include <math.h>
+
+/* A region of space being searched. */
+struct region {
+	/* The bounding box of the region. */
+	VECT min, max;
+	/* The center and radius of a circle, or NULL for a rectangle. */
+	const VECT *center;
+	jwb_num_t radius;
+};
+
+/* Whether the world wraps around at the edges. */
+static int wraps(WORLD *world)
+{
+	return !REMOVING_DISTANT(world) && !WALLED(world);
+}
+
+/* Find the cells along one axis which could hold entities reaching into the
+ * range [min, max]. The cells start at `*first` and go on for `*count`,
+ * wrapping past the end `n` in worlds which wrap. Returns 0 if no cells are in
+ * range. */
+static int cell_range(WORLD *world, jwb_num_t min, jwb_num_t max,
+	jwb_num_t off, size_t n, size_t *first, size_t *count)
+{
+	jwb_num_t cs, lim, lo, hi;
+	size_t last;
+	if (max < min) {
+		return 0;
+	}
+	cs = world->cell_size;
+	lim = (jwb_num_t)n * cs;
+	/* Entities in cells up to one cell size away could reach the range. */
+	lo = min - off - cs;
+	hi = max - off + cs;
+	if (wraps(world)) {
+		if (hi - lo >= lim) {
+			*first = 0;
+			*count = n;
+			return 1;
+		}
+		hi -= lo;
+		lo = jwb__fframe(lo, lim);
+		hi += lo;
+		*first = (size_t)(lo / cs) % n;
+		last = hi / cs;
+		*count = last - (size_t)(lo / cs) + 1;
+		if (*count > n) {
+			*count = n;
+		}
+	} else {
+		/* Cell indices are rounded toward zero, so the first cell also
+		 * holds entities up to a cell size before the start. */
+		if (hi <= -cs || lo >= lim) {
+			return 0;
+		}
+		*first = lo < 0 ? 0 : (size_t)(lo / cs);
+		last = hi < 0 ? 0 : hi >= lim ? n - 1 : (size_t)(hi / cs);
+		if (*first >= n) {
+			*first = n - 1;
+		}
+		if (last >= n) {
+			last = n - 1;
+		}
+		*count = last - *first + 1;
+	}
+	return 1;
+}
+
+/* Get the displacement along one axis from `from` to `to`. In worlds which
+ * wrap, the nearest copy of `to` is used. */
+static jwb_num_t axis_delta(WORLD *world, jwb_num_t from, jwb_num_t to,
+	jwb_num_t lim)
+{
+	jwb_num_t delta = to - from;
+	if (wraps(world)) {
+		delta = jwb__fframe(delta + lim / 2, lim) - lim / 2;
+	}
+	return delta;
+}
+
+/* Get the distance along one axis from `pos` to the range [min, max]. In
+ * worlds which wrap, the range repeats every `lim`. */
+static jwb_num_t axis_gap(WORLD *world, jwb_num_t pos, jwb_num_t min,
+	jwb_num_t max, jwb_num_t lim)
+{
+	jwb_num_t above;
+	if (!wraps(world)) {
+		return pos < min ? min - pos : pos > max ? pos - max : 0;
+	}
+	if (max - min >= lim) {
+		return 0;
+	}
+	above = jwb__fframe(pos - min, lim);
+	if (above <= max - min) {
+		return 0;
+	}
+	above -= max - min;
+	return above < lim - (max - min) - above
+		? above : lim - (max - min) - above;
+}
+
+/* Check whether an entity touches the region. */
+static int touches(WORLD *world, const struct region *reg,
+	const struct jwb__entity *ent)
+{
+	jwb_num_t lim_x, lim_y, dx, dy, reach;
+	lim_x = (jwb_num_t)world->width * world->cell_size;
+	lim_y = (jwb_num_t)world->height * world->cell_size;
+	if (reg->center) {
+		dx = axis_delta(world, reg->center->x, ent->pos.x, lim_x);
+		dy = axis_delta(world, reg->center->y, ent->pos.y, lim_y);
+		reach = reg->radius + ent->radius;
+	} else {
+		dx = axis_gap(world, ent->pos.x, reg->min.x, reg->max.x, lim_x);
+		dy = axis_gap(world, ent->pos.y, reg->min.y, reg->max.y, lim_y);
+		reach = ent->radius;
+	}
+	return MUL(dx, dx) + MUL(dy, dy) <= MUL(reach, reach);
+}
+
+/* Find the entities touching a region, only looking in nearby cells. */
+static size_t query(WORLD *world, const struct region *reg,
+	EHANDLE *buf, size_t buf_size)
+{
+	size_t x0, nx, y0, ny, i, j, found = 0;
+	if (!cell_range(world, reg->min.x, reg->max.x, world->offset.x,
+	                world->width, &x0, &nx)
+	 || !cell_range(world, reg->min.y, reg->max.y, world->offset.y,
+	                world->height, &y0, &ny)) {
+		return 0;
+	}
+	for (j = 0; j < ny; ++j) {
+		size_t y = (y0 + j) % world->height;
+		for (i = 0; i < nx; ++i) {
+			size_t x = (x0 + i) % world->width;
+			EHANDLE ent;
+			for (ent = world->cells[y * world->width + x]; ent >= 0;
+			     ent = GET(world, ent).next) {
+				if (touches(world, reg, &GET(world, ent))) {
+					if (found < buf_size) {
+						buf[found] = ent;
+					}
+					++found;
+				}
+			}
+		}
+	}
+	return found;
+}
+
+size_t jwb_world_query_aabb(
+	WORLD *world,
+	const VECT *min,
+	const VECT *max,
+	EHANDLE *buf,
+	size_t buf_size)
+{
+	struct region reg;
+	if (!min || !max) {
+		return 0;
+	}
+	reg.min = *min;
+	reg.max = *max;
+	reg.center = NULL;
+	reg.radius = 0;
+	return query(world, &reg, buf, buf_size);
+}
+
+size_t jwb_world_query_circle(
+	WORLD *world,
+	const VECT *center,
+	jwb_num_t radius,
+	EHANDLE *buf,
+	size_t buf_size)
+{
+	struct region reg;
+	if (!center || radius < 0) {
+		return 0;
+	}
+	reg.min.x = center->x - radius;
+	reg.min.y = center->y - radius;
+	reg.max.x = center->x + radius;
+	reg.max.y = center->y + radius;
+	reg.center = center;
+	reg.radius = radius;
+	return query(world, &reg, buf, buf_size);
+}
+
+/* Get the index of the cell which would hold a coordinate relative to the
+ * world offset, rounding down. */
+static long cell_of(WORLD *world, jwb_num_t coord)
+{
+	long idx = coord / world->cell_size;
+	if ((jwb_num_t)idx * world->cell_size > coord) {
+		--idx;
+	}
+	return idx;
+}
+
+/* A function called for an entity found in a cell. */
+typedef void (*visitor_t)(WORLD *world, void *ctx, EHANDLE ent,
+	const VECT *center);
+
+/* Call `visit` on each entity in a cell with its center relative to the world
+ * offset. The cell coordinates are unwrapped, so in worlds which wrap, cells
+ * past the edges stand for copies of the grid. In other worlds, the first row
+ * and column also hold entities up to a cell size before the grid, which are
+ * treated as being in the cells at -1. */
+static void visit_cell(WORLD *world, long ux, long uy, visitor_t visit,
+	void *ctx)
+{
+	jwb_num_t lim_x, lim_y, shift_x = 0, shift_y = 0;
+	long x, y;
+	EHANDLE ent;
+	lim_x = (jwb_num_t)world->width * world->cell_size;
+	lim_y = (jwb_num_t)world->height * world->cell_size;
+	if (wraps(world)) {
+		long kx = ux / (long)world->width;
+		long ky = uy / (long)world->height;
+		/* Round the copy numbers down. */
+		if (ux < kx * (long)world->width) {
+			--kx;
+		}
+		if (uy < ky * (long)world->height) {
+			--ky;
+		}
+		x = ux - kx * (long)world->width;
+		y = uy - ky * (long)world->height;
+		shift_x = (jwb_num_t)kx * lim_x;
+		shift_y = (jwb_num_t)ky * lim_y;
+	} else {
+		if (ux < -1 || uy < -1 || ux >= (long)world->width
+		 || uy >= (long)world->height) {
+			return;
+		}
+		x = ux < 0 ? 0 : ux;
+		y = uy < 0 ? 0 : uy;
+	}
+	for (ent = world->cells[y * world->width + x]; ent >= 0;
+	     ent = GET(world, ent).next) {
+		VECT center;
+		center.x = GET(world, ent).pos.x - world->offset.x;
+		center.y = GET(world, ent).pos.y - world->offset.y;
+		if (wraps(world)) {
+			center.x = jwb__fframe(center.x, lim_x) + shift_x;
+			center.y = jwb__fframe(center.y, lim_y) + shift_y;
+		} else if ((x == 0 && (center.x < 0) != (ux < 0))
+		        || (y == 0 && (center.y < 0) != (uy < 0))) {
+			continue;
+		}
+		visit(world, ctx, ent, &center);
+	}
+}
+
+/* A ray being cast. */
+struct ray {
+	/* Where the ray starts relative to the world offset. */
+	VECT origin;
+	/* The unit direction of the ray. */
+	VECT dir;
+	jwb_num_t max_dist;
+	jwb_ray_filter_t filter;
+	/* The nearest hits found so far, sorted by distance. */
+	struct jwb_ray_hit *hits;
+	size_t hits_size;
+	/* The total number of hits found. */
+	size_t n_hits;
+};
+
+/* Record a hit, keeping the stored hits sorted and dropping the farthest if
+ * there is no room. */
+static void add_hit(struct ray *ray, EHANDLE ent, jwb_num_t dist,
+	const VECT *normal)
+{
+	size_t i = ray->n_hits < ray->hits_size ? ray->n_hits : ray->hits_size;
+	++ray->n_hits;
+	if (i == ray->hits_size) {
+		if (i == 0 || ray->hits[i - 1].dist <= dist) {
+			return;
+		}
+		--i;
+	}
+	for (; i > 0 && ray->hits[i - 1].dist > dist; --i) {
+		ray->hits[i] = ray->hits[i - 1];
+	}
+	ray->hits[i].ent = ent;
+	ray->hits[i].dist = dist;
+	ray->hits[i].normal = *normal;
+}
+
+/* Check whether the ray hits a circle at `center`, recording it if so. */
+static void hit_circle(struct ray *ray, EHANDLE ent, const VECT *center,
+	jwb_num_t radius)
+{
+	VECT rel, perp, normal;
+	jwb_num_t along, outside, disc, root, dist;
+	rel.x = ray->origin.x - center->x;
+	rel.y = ray->origin.y - center->y;
+	along = MUL(rel.x, ray->dir.x) + MUL(rel.y, ray->dir.y);
+	outside = MUL(rel.x, rel.x) + MUL(rel.y, rel.y) - MUL(radius, radius);
+	if (outside > 0 && along > 0) {
+		/* The ray starts outside and points away. */
+		return;
+	}
+	/* Going by the part of `rel` across the ray keeps the numbers small
+	 * for rays which only graze the circle. */
+	perp.x = rel.x - MUL(along, ray->dir.x);
+	perp.y = rel.y - MUL(along, ray->dir.y);
+	disc = MUL(radius, radius) - MUL(perp.x, perp.x) - MUL(perp.y, perp.y);
+	if (disc < 0) {
+		return;
+	}
+	if (outside <= 0 || radius <= 0) {
+		dist = outside <= 0 ? 0 : -along;
+		normal.x = -ray->dir.x;
+		normal.y = -ray->dir.y;
+	} else {
+		root = SQRT(disc);
+		dist = -along - root;
+		normal.x = perp.x - MUL(root, ray->dir.x);
+		normal.y = perp.y - MUL(root, ray->dir.y);
+		/* The direction is only so close to unit length, which shows up
+		 * in the normal for small circles. */
+		jwb_vect_normalize(&normal);
+		if (normal.x == 0 && normal.y == 0) {
+			/* It was too small to measure. */
+			normal.x = -ray->dir.x;
+			normal.y = -ray->dir.y;
+		}
+	}
+	if (dist <= ray->max_dist) {
+		add_hit(ray, ent, dist, &normal);
+	}
+}
+
+/* Test an entity against a ray. */
+static void ray_visit(WORLD *world, void *ctx, EHANDLE ent, const VECT *center)
+{
+	struct ray *ray = ctx;
+	if (ray->filter && !ray->filter(world, ent)) {
+		return;
+	}
+	hit_circle(ray, ent, center, GET(world, ent).radius);
+}
+
+/* Walk the cells along the ray. Every cell within one cell of a cell which the
+ * ray passes through is tested exactly once. Since entities are no bigger than
+ * cells, an entity found after the ray enters a cell can't be hit before that
+ * point. This lets the search stop early if `first_only` is set. */
+static void cast(WORLD *world, struct ray *ray, int first_only)
+{
+	jwb_num_t cs = world->cell_size, t_max_x = 0, t_max_y = 0;
+	jwb_num_t t_delta_x = 0, t_delta_y = 0;
+	long cx, cy, step_x, step_y, i, j;
+	cx = cell_of(world, ray->origin.x);
+	cy = cell_of(world, ray->origin.y);
+	step_x = ray->dir.x > 0 ? 1 : ray->dir.x < 0 ? -1 : 0;
+	step_y = ray->dir.y > 0 ? 1 : ray->dir.y < 0 ? -1 : 0;
+	if (step_x) {
+		t_max_x = DIV((jwb_num_t)(cx + (step_x > 0)) * cs
+			- ray->origin.x, ray->dir.x);
+		t_delta_x = DIV(cs, ray->dir.x * step_x);
+	}
+	if (step_y) {
+		t_max_y = DIV((jwb_num_t)(cy + (step_y > 0)) * cs
+			- ray->origin.y, ray->dir.y);
+		t_delta_y = DIV(cs, ray->dir.y * step_y);
+	}
+	for (j = -1; j <= 1; ++j) {
+		for (i = -1; i <= 1; ++i) {
+			visit_cell(world, cx + i, cy + j, ray_visit, ray);
+		}
+	}
+	while (step_x || step_y) {
+		int along_x = step_x && (!step_y || t_max_x < t_max_y);
+		jwb_num_t t = along_x ? t_max_x : t_max_y;
+		if (t > ray->max_dist
+		 || (first_only && ray->n_hits > 0 && ray->hits[0].dist <= t)) {
+			break;
+		}
+		if (along_x) {
+			cx += step_x;
+			t_max_x += t_delta_x;
+			for (j = -1; j <= 1; ++j) {
+				visit_cell(world, cx + step_x, cy + j,
+					ray_visit, ray);
+			}
+		} else {
+			cy += step_y;
+			t_max_y += t_delta_y;
+			for (i = -1; i <= 1; ++i) {
+				visit_cell(world, cx + i, cy + step_y,
+					ray_visit, ray);
+			}
+		}
+		/* Worlds which don't wrap can be left for good. */
+		if (!wraps(world)
+		 && ((step_x > 0 && cx > (long)world->width)
+		  || (step_x < 0 && cx < -2)
+		  || (step_y > 0 && cy > (long)world->height)
+		  || (step_y < 0 && cy < -2))) {
+			break;
+		}
+	}
+}
+
+/* Set up a ray. Returns JWBE_INVALID_ARGUMENT if the arguments are bad. */
+static int init_ray(WORLD *world, struct ray *ray, const VECT *origin,
+	const VECT *dir, jwb_num_t max_dist, jwb_ray_filter_t filter)
+{
+	if (!origin || !dir || (dir->x == 0 && dir->y == 0) || max_dist < 0) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	ray->origin.x = origin->x - world->offset.x;
+	ray->origin.y = origin->y - world->offset.y;
+	if (wraps(world)) {
+		ray->origin.x = jwb__fframe(ray->origin.x,
+			(jwb_num_t)world->width * world->cell_size);
+		ray->origin.y = jwb__fframe(ray->origin.y,
+			(jwb_num_t)world->height * world->cell_size);
+	}
+	ray->dir = *dir;
+	jwb_vect_normalize(&ray->dir);
+	ray->max_dist = max_dist;
+	ray->filter = filter;
+	ray->n_hits = 0;
+	return 0;
+}
+
+int jwb_world_raycast(
+	WORLD *world,
+	const VECT *origin,
+	const VECT *dir,
+	jwb_num_t max_dist,
+	jwb_ray_filter_t filter,
+	struct jwb_ray_hit *hit)
+{
+	struct ray ray;
+	int err;
+	if (!hit) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	err = init_ray(world, &ray, origin, dir, max_dist, filter);
+	if (err) {
+		return err;
+	}
+	ray.hits = hit;
+	ray.hits_size = 1;
+	cast(world, &ray, 1);
+	return ray.n_hits > 0;
+}
+
+size_t jwb_world_raycast_all(
+	WORLD *world,
+	const VECT *origin,
+	const VECT *dir,
+	jwb_num_t max_dist,
+	jwb_ray_filter_t filter,
+	struct jwb_ray_hit *hits,
+	size_t hits_size)
+{
+	struct ray ray;
+	if (init_ray(world, &ray, origin, dir, max_dist, filter)) {
+		return 0;
+	}
+	ray.hits = hits;
+	ray.hits_size = hits_size;
+	cast(world, &ray, 0);
+	return ray.n_hits;
+}
+
+/* A search for the nearest entities to a point. */
+struct knn {
+	/* The point relative to the world offset. */
+	VECT point;
+	jwb_num_t lim_x, lim_y;
+	/* The nearest entities found so far, sorted by squared distance. */
+	struct jwb_neighbor *out;
+	size_t k, n;
+};
+
+/* Consider an entity as one of the nearest. */
+static void knn_visit(WORLD *world, void *ctx, EHANDLE ent, const VECT *center)
+{
+	struct knn *knn = ctx;
+	jwb_num_t dx, dy, dist2;
+	size_t i;
+	dx = axis_delta(world, knn->point.x, center->x, knn->lim_x);
+	dy = axis_delta(world, knn->point.y, center->y, knn->lim_y);
+	dist2 = MUL(dx, dx) + MUL(dy, dy);
+	if (knn->n < knn->k) {
+		i = knn->n++;
+	} else if (knn->out[knn->k - 1].dist > dist2) {
+		i = knn->k - 1;
+	} else {
+		return;
+	}
+	for (; i > 0 && knn->out[i - 1].dist > dist2; --i) {
+		knn->out[i] = knn->out[i - 1];
+	}
+	knn->out[i].ent = ent;
+	knn->out[i].dist = dist2;
+}
+
+/* Visit the cells `r` cells away from (cx, cy) in the larger direction. Only
+ * cells with offsets in [xlo, xhi] and [ylo, yhi] are visited. */
+static void visit_ring(WORLD *world, long cx, long cy, long r,
+	long xlo, long xhi, long ylo, long yhi, visitor_t visit, void *ctx)
+{
+	long dx, dy;
+	if (-r > xlo) {
+		xlo = -r;
+	}
+	if (r < xhi) {
+		xhi = r;
+	}
+	for (dy = -r > ylo ? -r : ylo; dy <= r && dy <= yhi; ++dy) {
+		if (dy == -r || dy == r) {
+			for (dx = xlo; dx <= xhi; ++dx) {
+				visit_cell(world, cx + dx, cy + dy, visit, ctx);
+			}
+		} else {
+			if (-r == xlo) {
+				visit_cell(world, cx - r, cy + dy, visit, ctx);
+			}
+			if (r == xhi) {
+				visit_cell(world, cx + r, cy + dy, visit, ctx);
+			}
+		}
+	}
+}
+
+/* Get the larger absolute value of two numbers. */
+static long abs_max(long a, long b)
+{
+	a = a < 0 ? -a : a;
+	b = b < 0 ? -b : b;
+	return a > b ? a : b;
+}
+
+size_t jwb_world_knn(
+	WORLD *world,
+	const VECT *point,
+	size_t k,
+	struct jwb_neighbor *out)
+{
+	struct knn knn;
+	long cx, cy, r, max_r, xlo, xhi, ylo, yhi;
+	size_t i;
+	if (!point || !out || k == 0) {
+		return 0;
+	}
+	knn.lim_x = (jwb_num_t)world->width * world->cell_size;
+	knn.lim_y = (jwb_num_t)world->height * world->cell_size;
+	knn.point.x = point->x - world->offset.x;
+	knn.point.y = point->y - world->offset.y;
+	if (wraps(world)) {
+		knn.point.x = jwb__fframe(knn.point.x, knn.lim_x);
+		knn.point.y = jwb__fframe(knn.point.y, knn.lim_y);
+	}
+	cx = cell_of(world, knn.point.x);
+	cy = cell_of(world, knn.point.y);
+	if (wraps(world)) {
+		/* Look at each column and row once, as near to the point as
+		 * possible. */
+		xlo = -(long)((world->width - 1) / 2);
+		xhi = xlo + (long)world->width - 1;
+		ylo = -(long)((world->height - 1) / 2);
+		yhi = ylo + (long)world->height - 1;
+	} else {
+		xlo = -1 - cx;
+		xhi = (long)world->width - 1 - cx;
+		ylo = -1 - cy;
+		yhi = (long)world->height - 1 - cy;
+	}
+	max_r = abs_max(abs_max(xlo, xhi), abs_max(ylo, yhi));
+	knn.out = out;
+	knn.k = k;
+	knn.n = 0;
+	for (r = 0; r <= max_r; ++r) {
+		jwb_num_t reach = (jwb_num_t)r * world->cell_size;
+		visit_ring(world, cx, cy, r, xlo, xhi, ylo, yhi,
+			knn_visit, &knn);
+		/* Entities in further rings are further than `reach` away. */
+		if (knn.n == k && out[k - 1].dist <= MUL(reach, reach)) {
+			break;
+		}
+	}
+	for (i = 0; i < knn.n; ++i) {
+		out[i].dist = SQRT(out[i].dist);
+	}
+	return knn.n;
+}
+
+void jwb_world_knn_batch(
+	WORLD *world,
+	size_t n_points,
+	const VECT *points,
+	size_t k,
+	struct jwb_neighbor *out,
+	size_t *counts)
+{
+	size_t i;
+	for (i = 0; i < n_points; ++i) {
+		counts[i] = jwb_world_knn(world, &points[i], k, out + i * k);
+	}
+}
+
+/* Pairs being gathered. */
+struct pair_search {
+	jwb_num_t margin, lim_x, lim_y;
+	/* The offsets of the neighboring cells to look at. */
+	long xlo, xhi, ylo, yhi;
+	struct jwb_pair *pairs;
+	size_t pairs_size;
+	/* The total number of pairs found. */
+	size_t n_pairs;
+};
+
+/* Record two entities as a pair if they are close enough. */
+static void check_pair(WORLD *world, struct pair_search *search,
+	EHANDLE ent1, EHANDLE ent2)
+{
+	struct jwb__entity *self, *other;
+	struct jwb_pair *pair;
+	jwb_num_t reach;
+	VECT rel;
+	self = &GET(world, ent1);
+	other = &GET(world, ent2);
+	rel.x = axis_delta(world, self->pos.x, other->pos.x, search->lim_x);
+	rel.y = axis_delta(world, self->pos.y, other->pos.y, search->lim_y);
+	reach = self->radius + other->radius + search->margin;
+	if (MUL(rel.x, rel.x) + MUL(rel.y, rel.y) >= MUL(reach, reach)) {
+		return;
+	}
+	if (search->n_pairs < search->pairs_size) {
+		pair = &search->pairs[search->n_pairs];
+		/* The lesser handle comes first, as with contacts. */
+		if (ent1 > ent2) {
+			EHANDLE tmp = ent1;
+			ent1 = ent2;
+			ent2 = tmp;
+			rel.x = -rel.x;
+			rel.y = -rel.y;
+		}
+		pair->ent1 = ent1;
+		pair->ent2 = ent2;
+		pair->info.rel = rel;
+		pair->info.dist = jwb_vect_magnitude(&rel);
+	}
+	++search->n_pairs;
+}
+
+/* Check the pairs of entities between two cells, or within one cell if they
+ * are the same. */
+static void pair_cells(WORLD *world, struct pair_search *search,
+	size_t cell1, size_t cell2)
+{
+	EHANDLE ent1, ent2;
+	for (ent1 = world->cells[cell1]; ent1 >= 0;
+	     ent1 = GET(world, ent1).next) {
+		ent2 = cell1 == cell2
+			? GET(world, ent1).next : world->cells[cell2];
+		for (; ent2 >= 0; ent2 = GET(world, ent2).next) {
+			check_pair(world, search, ent1, ent2);
+		}
+	}
+}
+
+/* Get the offsets of the neighboring cells to look at along one axis, given
+ * how many layers of cells around each cell are needed. In worlds which wrap,
+ * no column or row is included twice. */
+static void neighbor_range(WORLD *world, size_t n, long layers,
+	long *lo, long *hi)
+{
+	if (wraps(world) && (size_t)layers * 2 + 1 >= n) {
+		*lo = -(long)((n - 1) / 2);
+		*hi = *lo + (long)n - 1;
+	} else {
+		*lo = -layers;
+		*hi = layers;
+	}
+}
+
+/* Check the pairs between a cell and its neighbors. Each pair of cells is
+ * visited from the lesser one. */
+static void pair_neighbors(WORLD *world, struct pair_search *search,
+	size_t x, size_t y)
+{
+	size_t here = y * world->width + x;
+	long dx, dy;
+	for (dy = search->ylo; dy <= search->yhi; ++dy) {
+		for (dx = search->xlo; dx <= search->xhi; ++dx) {
+			long w = world->width, h = world->height;
+			long nx = (long)x + dx, ny = (long)y + dy;
+			size_t there;
+			if (wraps(world)) {
+				nx = (nx + w) % w;
+				ny = (ny + h) % h;
+			} else if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+				continue;
+			}
+			there = (size_t)ny * world->width + (size_t)nx;
+			if (there > here) {
+				pair_cells(world, search, here, there);
+			}
+		}
+	}
+}
+
+size_t jwb_world_pairs(
+	WORLD *world,
+	jwb_num_t margin,
+	struct jwb_pair *pairs,
+	size_t pairs_size)
+{
+	struct pair_search search;
+	jwb_num_t max_radius = 0, reach;
+	long layers;
+	size_t i, x, y;
+	if (margin < 0) {
+		return 0;
+	}
+	for (i = 0; i < world->n_alive; ++i) {
+		jwb_num_t radius = GET(world, ALIVE(world, i)).radius;
+		if (radius > max_radius) {
+			max_radius = radius;
+		}
+	}
+	/* Usually entities only reach into neighboring cells, like during
+	 * simulation, but a margin or large entities can need more layers. */
+	reach = max_radius * 2 + margin;
+	for (layers = 1; (jwb_num_t)layers * world->cell_size < reach
+	                 && (size_t)layers < world->width + world->height;
+	     ++layers);
+	neighbor_range(world, world->width, layers, &search.xlo, &search.xhi);
+	neighbor_range(world, world->height, layers, &search.ylo, &search.yhi);
+	search.margin = margin;
+	search.lim_x = (jwb_num_t)world->width * world->cell_size;
+	search.lim_y = (jwb_num_t)world->height * world->cell_size;
+	search.pairs = pairs;
+	search.pairs_size = pairs_size;
+	search.n_pairs = 0;
+	for (y = 0; y < world->height; ++y) {
+		for (x = 0; x < world->width; ++x) {
+			size_t here = y * world->width + x;
+			if (world->cells[here] < 0) {
+				continue;
+			}
+			pair_cells(world, &search, here, here);
+			pair_neighbors(world, &search, x, y);
+		}
+	}
+	return search.n_pairs;
+}
+
+/* Entities being gathered for a view. */
+struct view {
+	VECT min, max;
+	struct jwb_visible *buf;
+	size_t buf_size;
+	/* The total number of visible entities found. */
+	size_t n_visible;
+};
+
+/* Add an entity to the view if it touches it. */
+static void view_visit(WORLD *world, void *ctx, EHANDLE ent, const VECT *center)
+{
+	struct view *view = ctx;
+	jwb_num_t gap_x, gap_y, radius = GET(world, ent).radius;
+	gap_x = center->x < view->min.x ? view->min.x - center->x
+		: center->x > view->max.x ? center->x - view->max.x : 0;
+	gap_y = center->y < view->min.y ? view->min.y - center->y
+		: center->y > view->max.y ? center->y - view->max.y : 0;
+	if (MUL(gap_x, gap_x) + MUL(gap_y, gap_y) > MUL(radius, radius)) {
+		return;
+	}
+	if (view->n_visible < view->buf_size) {
+		struct jwb_visible *vis = &view->buf[view->n_visible];
+		vis->ent = ent;
+		vis->pos = *center;
+		vis->radius = radius;
+	}
+	++view->n_visible;
+}
+
+size_t jwb_world_visible(
+	WORLD *world,
+	const VECT *view_min,
+	const VECT *view_max,
+	struct jwb_visible *buf,
+	size_t buf_size)
+{
+	struct view view;
+	long x, y, x_lo, x_hi, y_lo, y_hi;
+	if (!view_min || !view_max || view_max->x < view_min->x
+	 || view_max->y < view_min->y) {
+		return 0;
+	}
+	view.min = *view_min;
+	view.max = *view_max;
+	view.buf = buf;
+	view.buf_size = buf_size;
+	view.n_visible = 0;
+	/* Entities in cells up to one cell size outside the view could reach
+	 * into it. Cells past the edges of worlds which wrap are copies. */
+	x_lo = cell_of(world, view.min.x - world->cell_size);
+	x_hi = cell_of(world, view.max.x + world->cell_size);
+	y_lo = cell_of(world, view.min.y - world->cell_size);
+	y_hi = cell_of(world, view.max.y + world->cell_size);
+	if (!wraps(world)) {
+		x_lo = x_lo < -1 ? -1 : x_lo;
+		y_lo = y_lo < -1 ? -1 : y_lo;
+		x_hi = x_hi < (long)world->width ? x_hi : (long)world->width - 1;
+		y_hi = y_hi < (long)world->height
+			? y_hi : (long)world->height - 1;
+	}
+	for (y = y_lo; y <= y_hi; ++y) {
+		for (x = x_lo; x <= x_hi; ++x) {
+			visit_cell(world, x, y, view_visit, &view);
+		}
+	}
+	return view.n_visible;
+}
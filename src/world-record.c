@@ -0,0 +1,612 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+#include <math.h>
+#include <string.h>
+
+/* A recording is "JWBR", a version byte, and the quantum in units of 1/65536
+ * as a varint, followed by frames. Each frame is the varint size of the rest
+ * of the frame, a type byte, and a list of changes. Each change is a varint
+ * tag holding the difference between its handle and that of the last change
+ * (or 0) shifted left by two, with the kind of change in the low two bits. The
+ * kind is followed by its data. Coordinates are in quanta, and are signed
+ * varints with the sign in the lowest bit. */
+#define RECORDING_VERSION 1
+#define QUANTUM_UNITS 65536.
+
+/* Types of frame. Key frames start with nothing and spawn every entity. */
+#define DELTA_FRAME 0
+#define KEY_FRAME 1
+
+/* Kinds of change. */
+#define MOVED 0 /* Signed change in x and y. */
+#define SPAWNED 1 /* Signed x and y, then unsigned radius. */
+#define DESPAWNED 2 /* Nothing. */
+#define RESIZED 3 /* Unsigned radius. */
+
+/* The most bytes a varint can take. */
+#define MAX_VARINT ((sizeof(unsigned long) * CHAR_BIT + 6) / 7)
+
+/* What was last written about a handle. */
+struct ent_state {
+	long x, y, r;
+	int living;
+};
+
+/* The state of a world's recording. */
+struct recorder {
+	jwb_write_t write;
+	void *ctx;
+	double quantum;
+	unsigned keyframe_interval, countdown;
+	/* Whether the next frame must be a key frame. */
+	int force_key;
+	/* The first error, after which nothing more is written. */
+	int error;
+	struct ent_state *ents;
+	size_t n_handles, ents_cap;
+	/* The frame being encoded. */
+	unsigned char *buf;
+	size_t len, buf_cap;
+	size_t last_handle;
+};
+
+/* Put a varint in a buffer which has room. Returns the new end. */
+static unsigned char *put_varint(unsigned char *dst, unsigned long num)
+{
+	while (num >= 0x80) {
+		*dst++ = (unsigned char)(num & 0x7f) | 0x80;
+		num >>= 7;
+	}
+	*dst++ = (unsigned char)num;
+	return dst;
+}
+
+/* Read a varint, moving past it. Returns -1 if it runs past `end`. */
+static int get_varint(const unsigned char **src, const unsigned char *end,
+	unsigned long *num)
+{
+	unsigned shift = 0;
+	*num = 0;
+	while (*src < end && shift < sizeof(*num) * CHAR_BIT) {
+		unsigned char byte = *(*src)++;
+		*num |= (unsigned long)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return 0;
+		}
+		shift += 7;
+	}
+	return -1;
+}
+
+/* Map signed numbers to unsigned ones, with small magnitudes staying small. */
+static unsigned long zigzag(long num)
+{
+	return num < 0 ? ~((unsigned long)num << 1) : (unsigned long)num << 1;
+}
+
+static long unzigzag(unsigned long num)
+{
+	return num & 1 ? -(long)(num >> 1) - 1 : (long)(num >> 1);
+}
+
+static long quantize(const struct recorder *rec, jwb_num_t num)
+{
+	return (long)floor(JWB_NUM_TO_DOUBLE(num) / rec->quantum + .5);
+}
+
+/* Make room for `size` more bytes in the frame. Returns JWBE_NO_MEMORY on
+ * failure. */
+static int frame_room(WORLD *world, struct recorder *rec, size_t size)
+{
+	if (rec->len + size > rec->buf_cap) {
+		size_t new_cap = (rec->len + size) * 2;
+		unsigned char *new_buf = REALLOC(world, rec->buf, new_cap);
+		if (!new_buf) {
+			return -JWBE_NO_MEMORY;
+		}
+		rec->buf = new_buf;
+		rec->buf_cap = new_cap;
+	}
+	return 0;
+}
+
+/* Start a change to a handle in the frame, which must have room. */
+static void put_change(struct recorder *rec, size_t ent, int kind)
+{
+	rec->len = put_varint(rec->buf + rec->len,
+		(unsigned long)(ent - rec->last_handle) << 2 | kind) - rec->buf;
+	rec->last_handle = ent;
+}
+
+static void put_num(struct recorder *rec, unsigned long num)
+{
+	rec->len = put_varint(rec->buf + rec->len, num) - rec->buf;
+}
+
+/* Make sure there is state for every handle in the world. */
+static int grow_states(WORLD *world, struct recorder *rec)
+{
+	if (world->n_ents > rec->ents_cap) {
+		size_t new_cap = world->n_ents * 3 / 2 + 16;
+		struct ent_state *ents = REALLOC(world, rec->ents,
+			new_cap * sizeof(*ents));
+		if (!ents) {
+			return -JWBE_NO_MEMORY;
+		}
+		rec->ents = ents;
+		rec->ents_cap = new_cap;
+	}
+	while (rec->n_handles < world->n_ents) {
+		rec->ents[rec->n_handles++].living = 0;
+	}
+	return 0;
+}
+
+/* Encode the changes since the last frame and write them. The space before
+ * the changes is left for the frame header. */
+static int record_frame(WORLD *world, struct recorder *rec, int key)
+{
+	unsigned char header[MAX_VARINT + 1], *header_end;
+	size_t ent, start = sizeof(header);
+	int err;
+	if ((err = grow_states(world, rec))) {
+		return err;
+	}
+	rec->len = start;
+	rec->last_handle = 0;
+	for (ent = 0; ent < rec->n_handles; ++ent) {
+		struct ent_state *state = &rec->ents[ent];
+		const struct jwb__entity *e;
+		long x, y, r;
+		if ((err = frame_room(world, rec, 4 * MAX_VARINT))) {
+			return err;
+		}
+		e = ent < world->n_ents ? &GET(world, (EHANDLE)ent) : NULL;
+		if (!e || e->flags & (REMOVED | DESTROYED)) {
+			if (state->living && !key) {
+				put_change(rec, ent, DESPAWNED);
+			}
+			state->living = 0;
+			continue;
+		}
+		x = quantize(rec, e->pos.x);
+		y = quantize(rec, e->pos.y);
+		r = quantize(rec, e->radius);
+		if (key || !state->living) {
+			put_change(rec, ent, SPAWNED);
+			put_num(rec, zigzag(x));
+			put_num(rec, zigzag(y));
+			put_num(rec, r);
+		} else {
+			if (x != state->x || y != state->y) {
+				put_change(rec, ent, MOVED);
+				put_num(rec, zigzag(x - state->x));
+				put_num(rec, zigzag(y - state->y));
+			}
+			if (r != state->r) {
+				put_change(rec, ent, RESIZED);
+				put_num(rec, r);
+			}
+		}
+		state->x = x;
+		state->y = y;
+		state->r = r;
+		state->living = 1;
+	}
+	header_end = put_varint(header, rec->len - start + 1);
+	*header_end++ = key ? KEY_FRAME : DELTA_FRAME;
+	start -= header_end - header;
+	memcpy(rec->buf + start, header, header_end - header);
+	if (rec->write(rec->ctx, rec->buf + start, rec->len - start)) {
+		return -JWBE_IO;
+	}
+	return 0;
+}
+
+/* Free a recorder and everything it holds. */
+static void free_recorder(WORLD *world, struct recorder *rec)
+{
+	FREE(world, rec->ents);
+	FREE(world, rec->buf);
+	FREE(world, rec);
+}
+
+int jwb_world_record_frames(
+	WORLD *world,
+	jwb_num_t quantum,
+	unsigned keyframe_interval,
+	jwb_write_t write,
+	void *ctx)
+{
+	unsigned char header[5 + MAX_VARINT];
+	struct recorder *rec = world->recorder;
+	double units;
+	int err = 0;
+	if (rec) {
+		err = rec->error;
+		free_recorder(world, rec);
+		world->recorder = NULL;
+	}
+	if (!write) {
+		return err;
+	}
+	units = floor(JWB_NUM_TO_DOUBLE(quantum) * QUANTUM_UNITS + .5);
+	if (units < 1. || units > (double)LONG_MAX) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	rec = ALLOC(world, sizeof(*rec));
+	if (!rec) {
+		return -JWBE_NO_MEMORY;
+	}
+	rec->write = write;
+	rec->ctx = ctx;
+	rec->quantum = units / QUANTUM_UNITS;
+	rec->keyframe_interval = keyframe_interval;
+	rec->countdown = keyframe_interval;
+	rec->force_key = 0;
+	rec->error = 0;
+	rec->ents = NULL;
+	rec->n_handles = rec->ents_cap = 0;
+	rec->buf = NULL;
+	rec->len = rec->buf_cap = 0;
+	memcpy(header, "JWBR", 4);
+	header[4] = RECORDING_VERSION;
+	if (write(ctx, header, put_varint(header + 5, (unsigned long)units)
+		- header)) {
+		err = -JWBE_IO;
+	} else {
+		err = record_frame(world, rec, 1);
+	}
+	if (err) {
+		free_recorder(world, rec);
+		return err;
+	}
+	world->recorder = rec;
+	return 0;
+}
+
+void jwb__record_frame(WORLD *world)
+{
+	struct recorder *rec = world->recorder;
+	int key;
+	if (rec->error) {
+		return;
+	}
+	key = rec->force_key;
+	if (rec->keyframe_interval > 0 && --rec->countdown == 0) {
+		key = 1;
+	}
+	if (key) {
+		rec->countdown = rec->keyframe_interval;
+		rec->force_key = 0;
+	}
+	rec->error = record_frame(world, rec, key);
+}
+
+void jwb__restart_frames(WORLD *world)
+{
+	struct recorder *rec = world->recorder;
+	rec->force_key = 1;
+}
+
+size_t jwb__recorder_memory(WORLD *world)
+{
+	struct recorder *rec = world->recorder;
+	if (!rec) {
+		return 0;
+	}
+	return sizeof(*rec) + rec->ents_cap * sizeof(*rec->ents)
+		+ rec->buf_cap;
+}
+
+void jwb__free_recorder(WORLD *world)
+{
+	if (world->recorder) {
+		free_recorder(world, world->recorder);
+		world->recorder = NULL;
+	}
+}
+
+int jwb_reader_open(
+	jwb_reader_t *reader,
+	const void *data,
+	size_t size,
+	const struct jwb_allocator *allocator)
+{
+	const unsigned char *src = data, *end;
+	unsigned long units;
+	if (!data) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	end = src + size;
+	if (size < 5 || memcmp(src, "JWBR", 4) || src[4] != RECORDING_VERSION) {
+		return -JWBE_BAD_RECORDING;
+	}
+	src += 5;
+	if (get_varint(&src, end, &units) || units == 0) {
+		return -JWBE_BAD_RECORDING;
+	}
+#ifndef JWBO_NO_ALLOC
+	reader->allocator = allocator ? *allocator : jwb__default_allocator;
+#else
+	(void)allocator;
+#endif
+	reader->data = data;
+	reader->size = size;
+	reader->start = src - reader->data;
+	reader->next = reader->start;
+	reader->frame = -1;
+	reader->quantum = units / QUANTUM_UNITS;
+	reader->state = NULL;
+	reader->handles = NULL;
+	reader->living = NULL;
+	reader->n_handles = reader->handles_cap = 0;
+	reader->keys = NULL;
+	reader->n_keys = reader->keys_cap = 0;
+	return 0;
+}
+
+void jwb_reader_close(jwb_reader_t *reader)
+{
+	FREE(reader, reader->state);
+	FREE(reader, reader->keys);
+}
+
+/* Read the header of the frame at `offset`, giving where its changes start and
+ * end. Returns JWBE_BAD_RECORDING if it is damaged. */
+static int frame_header(const jwb_reader_t *reader, size_t offset,
+	const unsigned char **changes, const unsigned char **end, int *type)
+{
+	const unsigned char *src = reader->data + offset;
+	const unsigned char *data_end = reader->data + reader->size;
+	unsigned long size;
+	if (get_varint(&src, data_end, &size) || size == 0
+	 || size > (unsigned long)(data_end - src)) {
+		return -JWBE_BAD_RECORDING;
+	}
+	*type = *src;
+	*changes = src + 1;
+	*end = src + size;
+	return *type == KEY_FRAME || *type == DELTA_FRAME
+		? 0 : -JWBE_BAD_RECORDING;
+}
+
+/* Remember where a key frame is, if it is past those already known. */
+static int index_key(jwb_reader_t *reader, long frame, size_t offset)
+{
+	if (reader->n_keys > 0
+	 && reader->keys[reader->n_keys - 1].frame >= frame) {
+		return 0;
+	}
+	if (reader->n_keys >= reader->keys_cap) {
+		size_t new_cap = reader->keys_cap * 2 + 16;
+		struct jwb__key_frame *keys = REALLOC(reader, reader->keys,
+			new_cap * sizeof(*keys));
+		if (!keys) {
+			return -JWBE_NO_MEMORY;
+		}
+		reader->keys = keys;
+		reader->keys_cap = new_cap;
+	}
+	reader->keys[reader->n_keys].frame = frame;
+	reader->keys[reader->n_keys].offset = offset;
+	++reader->n_keys;
+	return 0;
+}
+
+/* The bytes of state kept for each known handle. */
+#define SLOT_BYTES (3 * sizeof(long) + sizeof(EHANDLE) + 1)
+
+/* Insert a handle which has not been seen before at index `at` in the known
+ * handles. Only handles which are spawned are kept, and spawning one takes at
+ * least four bytes of the recording, so the memory used stays in proportion to
+ * the recording no matter what handles it names. */
+static int add_handle(jwb_reader_t *reader, size_t at, EHANDLE ent)
+{
+	size_t n = reader->n_handles, tail = n - at;
+	if (n >= reader->handles_cap) {
+		size_t new_cap = reader->handles_cap * 3 / 2 + 16;
+		char *block;
+		if (new_cap > (size_t)-1 / SLOT_BYTES) {
+			return -JWBE_NO_MEMORY;
+		}
+		block = ALLOC(reader, new_cap * SLOT_BYTES);
+		if (!block) {
+			return -JWBE_NO_MEMORY;
+		}
+		if (n > 0) {
+			memcpy(block, reader->state, n * 3 * sizeof(long));
+			memcpy(block + new_cap * 3 * sizeof(long),
+				reader->handles, n * sizeof(EHANDLE));
+			memcpy(block + new_cap
+				* (3 * sizeof(long) + sizeof(EHANDLE)),
+				reader->living, n);
+		}
+		FREE(reader, reader->state);
+		reader->state = (long *)block;
+		reader->handles = (EHANDLE *)(block
+			+ new_cap * 3 * sizeof(long));
+		reader->living = (unsigned char *)(block
+			+ new_cap * (3 * sizeof(long) + sizeof(EHANDLE)));
+		reader->handles_cap = new_cap;
+	}
+	memmove(&reader->state[(at + 1) * 3], &reader->state[at * 3],
+		tail * 3 * sizeof(long));
+	memmove(&reader->handles[at + 1], &reader->handles[at],
+		tail * sizeof(EHANDLE));
+	memmove(&reader->living[at + 1], &reader->living[at], tail);
+	reader->handles[at] = ent;
+	reader->living[at] = 0;
+	++reader->n_handles;
+	return 0;
+}
+
+/* Apply one change, moving past it. The changes in a frame go up by handle, so
+ * `slot` only moves forward through the known handles. */
+static int apply_change(jwb_reader_t *reader, const unsigned char **src,
+	const unsigned char *end, size_t *ent, size_t *slot)
+{
+	unsigned long tag, a = 0, b = 0, c = 0;
+	long *state;
+	int kind, err;
+	if (get_varint(src, end, &tag)
+	 || (tag >> 2) > (unsigned long)EHANDLE_MAX - *ent) {
+		return -JWBE_BAD_RECORDING;
+	}
+	*ent += tag >> 2;
+	kind = (int)(tag & 3);
+	if ((kind == MOVED || kind == SPAWNED) && (get_varint(src, end, &a)
+	 || get_varint(src, end, &b))) {
+		return -JWBE_BAD_RECORDING;
+	}
+	if ((kind == SPAWNED || kind == RESIZED) && get_varint(src, end, &c)) {
+		return -JWBE_BAD_RECORDING;
+	}
+	while (*slot < reader->n_handles
+	    && (size_t)reader->handles[*slot] < *ent) {
+		++*slot;
+	}
+	if (*slot == reader->n_handles
+	 || (size_t)reader->handles[*slot] != *ent) {
+		if (kind != SPAWNED) {
+			return -JWBE_BAD_RECORDING;
+		}
+		if ((err = add_handle(reader, *slot, (EHANDLE)*ent))) {
+			return err;
+		}
+	}
+	state = &reader->state[*slot * 3];
+	if (kind != SPAWNED && !reader->living[*slot]) {
+		return -JWBE_BAD_RECORDING;
+	}
+	switch (kind) {
+	case MOVED:
+		state[0] += unzigzag(a);
+		state[1] += unzigzag(b);
+		break;
+	case SPAWNED:
+		state[0] = unzigzag(a);
+		state[1] = unzigzag(b);
+		state[2] = (long)c;
+		reader->living[*slot] = 1;
+		break;
+	case DESPAWNED:
+		reader->living[*slot] = 0;
+		break;
+	case RESIZED:
+		state[2] = (long)c;
+		break;
+	}
+	return 0;
+}
+
+int jwb_reader_next(jwb_reader_t *reader)
+{
+	const unsigned char *src, *end;
+	size_t ent = 0, slot = 0;
+	int type, err;
+	if (reader->next >= reader->size) {
+		return 0;
+	}
+	if ((err = frame_header(reader, reader->next, &src, &end, &type))) {
+		return err;
+	}
+	if (type == KEY_FRAME) {
+		err = index_key(reader, reader->frame + 1, reader->next);
+		if (err) {
+			return err;
+		}
+		if (reader->n_handles > 0) {
+			memset(reader->living, 0, reader->n_handles);
+		}
+	} else if (reader->frame < 0) {
+		return -JWBE_BAD_RECORDING;
+	}
+	while (src < end) {
+		if ((err = apply_change(reader, &src, end, &ent, &slot))) {
+			return err;
+		}
+	}
+	reader->next = end - reader->data;
+	++reader->frame;
+	return 1;
+}
+
+int jwb_reader_seek(jwb_reader_t *reader, unsigned long frame)
+{
+	const unsigned char *src, *end;
+	size_t i, offset;
+	long at, target = (long)frame;
+	int type, err;
+	if (frame > (unsigned long)LONG_MAX) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	if (target < reader->frame) {
+		/* Go back to the last known key frame before the target. */
+		reader->frame = -1;
+		reader->next = reader->start;
+		for (i = reader->n_keys; i-- > 0;) {
+			if (reader->keys[i].frame <= target) {
+				reader->frame = reader->keys[i].frame - 1;
+				reader->next = reader->keys[i].offset;
+				break;
+			}
+		}
+	}
+	/* Skip to the last key frame up to the target without decoding the
+	 * frames before it. */
+	at = reader->frame + 1;
+	offset = reader->next;
+	while (at <= target && offset < reader->size) {
+		err = frame_header(reader, offset, &src, &end, &type);
+		if (err) {
+			return err;
+		}
+		if (type == KEY_FRAME) {
+			if ((err = index_key(reader, at, offset))) {
+				return err;
+			}
+			reader->frame = at - 1;
+			reader->next = offset;
+		}
+		offset = end - reader->data;
+		++at;
+	}
+	if (at <= target) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	while (reader->frame < target) {
+		err = jwb_reader_next(reader);
+		if (err <= 0) {
+			return err ? err : -JWBE_INVALID_ARGUMENT;
+		}
+	}
+	return 0;
+}
+
+long jwb_reader_frame(jwb_reader_t *reader)
+{
+	return reader->frame;
+}
+
+size_t jwb_reader_ents(
+	jwb_reader_t *reader,
+	struct jwb_frame_ent *buf,
+	size_t buf_size)
+{
+	size_t slot, n = 0;
+	for (slot = 0; slot < reader->n_handles; ++slot) {
+		const long *state = &reader->state[slot * 3];
+		if (!reader->living[slot]) {
+			continue;
+		}
+		if (n < buf_size) {
+			buf[n].ent = reader->handles[slot];
+			buf[n].pos.x = JWB_NUM(state[0] * reader->quantum);
+			buf[n].pos.y = JWB_NUM(state[1] * reader->quantum);
+			buf[n].radius = JWB_NUM(state[2] * reader->quantum);
+		}
+		++n;
+	}
+	return n;
+}
@@ -0,0 +1,356 @@
+#define JWB_INTERNAL_
+#include <jwb.h>
+#include <string.h>
+
+#define SNAPSHOT_VERSION 1
+
+/* How numbers are stored, so that snapshots from other builds are refused. */
+#ifdef JWBO_NUM_FIXED
+#	define NUM_KIND 2
+#elif defined(JWBO_NUM_FLOAT)
+#	define NUM_KIND 1
+#else
+#	define NUM_KIND 0
+#endif
+
+/* The start of a snapshot. It is followed by the cells, then the entities,
+ * their separate extra data, and the dense list padded to one handle per
+ * entity, which together form an unpaged entity buffer. */
+struct snapshot {
+	char magic[4];
+	unsigned char version, num_kind, num_size, handle_size;
+	unsigned long byte_order;
+	unsigned long ent_size, extra_size, ent_extra;
+	unsigned long width, height;
+	unsigned long n_ents, n_alive;
+	long freed, available, tracking;
+	unsigned long regrid_interval, regrid_countdown;
+	long flags;
+	jwb_num_t cell_size;
+	VECT offset, gravity;
+	jwb_num_t friction, damping;
+};
+
+#define CELLS_OFFSET JWB__ALIGN(sizeof(struct snapshot), 8)
+
+/* Get where the entities start in a snapshot. */
+static size_t ents_offset(const struct snapshot *snap)
+{
+	size_t n_cells = (size_t)snap->width * snap->height;
+	if (snap->flags & ONE_CELL_THICK) {
+		n_cells *= 4;
+	}
+	return CELLS_OFFSET + JWB__ALIGN(n_cells * snap->handle_size, 8);
+}
+
+#ifndef JWBO_PAGED_ENTS
+/* Get the size of a whole snapshot. */
+static size_t snapshot_size(const struct snapshot *snap)
+{
+	return ents_offset(snap) + snap->n_ents
+		* (snap->ent_size + snap->extra_size + snap->handle_size);
+}
+#endif
+
+/* Fill in the parts of a snapshot header which say how this build lays out
+ * its data. */
+static void fill_layout(struct snapshot *snap)
+{
+	memcpy(snap->magic, "JWBS", 4);
+	snap->version = SNAPSHOT_VERSION;
+	snap->num_kind = NUM_KIND;
+	snap->num_size = sizeof(jwb_num_t);
+	snap->handle_size = sizeof(EHANDLE);
+	snap->byte_order = 0x01020304UL;
+}
+
+/* Check a snapshot header. Returns JWBE_BAD_SNAPSHOT if it is not usable. */
+static int check_snapshot(const struct snapshot *snap)
+{
+	struct snapshot layout;
+	fill_layout(&layout);
+	if (memcmp(snap->magic, layout.magic, 4)
+	 || snap->version != layout.version
+	 || snap->num_kind != layout.num_kind
+	 || snap->num_size != layout.num_size
+	 || snap->handle_size != layout.handle_size
+	 || snap->byte_order != layout.byte_order
+	 || snap->width == 0 || snap->height == 0
+	 || snap->n_ents > (unsigned long)EHANDLE_MAX
+	 || snap->n_alive > snap->n_ents) {
+		return -JWBE_BAD_SNAPSHOT;
+	}
+	return 0;
+}
+
+/* Check whether a handle is -1 or belongs to the world. */
+static int valid_handle(WORLD *world, EHANDLE ent)
+{
+	return ent >= -1 && ent < (EHANDLE)world->n_ents;
+}
+
+/* Check that every handle stored in a loaded world is in range, so that a
+ * damaged snapshot cannot lead outside the buffers. Returns JWBE_BAD_SNAPSHOT
+ * if not. */
+static int check_handles(WORLD *world)
+{
+	size_t i, n_cells = world->width * world->height;
+	if (!valid_handle(world, world->freed)
+	 || !valid_handle(world, world->available)
+	 || !valid_handle(world, world->tracking)) {
+		return -JWBE_BAD_SNAPSHOT;
+	}
+	for (i = 0; i < n_cells; ++i) {
+		if (!valid_handle(world, world->cells[i])) {
+			return -JWBE_BAD_SNAPSHOT;
+		}
+	}
+	for (i = 0; i < world->n_alive; ++i) {
+		EHANDLE ent = ALIVE(world, i);
+		if (ent < 0 || !valid_handle(world, ent)
+		 || GET(world, ent).flags & (REMOVED | DESTROYED)
+		 || GET(world, ent).dense != (EHANDLE)i) {
+			return -JWBE_BAD_SNAPSHOT;
+		}
+	}
+	for (i = 0; i < world->n_ents; ++i) {
+		const struct jwb__entity *e = &GET(world, (EHANDLE)i);
+		int living = !(e->flags & (REMOVED | DESTROYED));
+		/* The first living entity in a cell links back to the cell. */
+		if (!valid_handle(world, e->next)
+		 || (living ? (e->last < 0 ? (size_t)~e->last >= n_cells
+		                           : e->last >= (EHANDLE)world->n_ents)
+		            : !valid_handle(world, e->last))
+		 || (living && (e->dense < 0
+		             || (size_t)e->dense >= world->n_alive
+		             || ALIVE(world, e->dense) != (EHANDLE)i))) {
+			return -JWBE_BAD_SNAPSHOT;
+		}
+	}
+	return 0;
+}
+
+/* Start a world with the settings in a snapshot, using the given buffers if
+ * they are not NULL. Returns an error from jwb_world_alloc, or
+ * JWBE_BAD_SNAPSHOT if the entities are laid out differently. */
+static int alloc_from(
+	WORLD *world,
+	const struct snapshot *snap,
+	const struct jwb_allocator *allocator,
+	void *ent_buf,
+	void *cell_buf)
+{
+	struct jwb_world_init info = JWB_WORLD_INIT_DEFAULT;
+	int err;
+	info.flags = (int)snap->flags & ~ONE_CELL_THICK;
+	info.cell_size = snap->cell_size;
+	info.width = snap->width;
+	info.height = snap->height;
+	info.ent_buf_size = snap->n_ents;
+	info.ent_extra = snap->ent_extra;
+	info.ent_buf = ent_buf;
+	info.cell_buf = cell_buf;
+	info.allocator = allocator;
+	err = jwb_world_alloc(world, &info);
+	if (err) {
+		return err;
+	}
+	if (world->ent_size != snap->ent_size
+	 || world->extra_size != snap->extra_size
+	 || (world->flags & ONE_CELL_THICK) != (snap->flags & ONE_CELL_THICK)) {
+		jwb_world_destroy(world);
+		return -JWBE_BAD_SNAPSHOT;
+	}
+	world->n_ents = snap->n_ents;
+	world->n_alive = snap->n_alive;
+	world->freed = snap->freed;
+	world->available = snap->available;
+	world->tracking = snap->tracking;
+	world->regrid_interval = snap->regrid_interval;
+	world->regrid_countdown = snap->regrid_countdown;
+	world->offset = snap->offset;
+	world->gravity = snap->gravity;
+	world->friction = snap->friction;
+	world->damping = snap->damping;
+	return 0;
+}
+
+/* Get how many entries starting at `i` are next to each other in memory. */
+static size_t run_length(size_t i, size_t n)
+{
+#ifdef JWBO_PAGED_ENTS
+	size_t left = PAGE_ENTS - (i & (PAGE_ENTS - 1));
+	return n - i < left ? n - i : left;
+#else
+	(void)i;
+	return n - i;
+#endif
+}
+
+/* Write or read bytes. Returns JWBE_IO on failure, or JWBE_BAD_SNAPSHOT if the
+ * file ended early. */
+static int transfer(FILE *file, void *buf, size_t size, int writing)
+{
+	size_t done;
+	if (size == 0) {
+		return 0;
+	}
+	done = writing ? fwrite(buf, 1, size, file) : fread(buf, 1, size, file);
+	if (done == size) {
+		return 0;
+	}
+	return !writing && feof(file) ? -JWBE_BAD_SNAPSHOT : -JWBE_IO;
+}
+
+/* Write or read the entities, extra data and dense list. */
+static int transfer_ents(WORLD *world, FILE *file, int writing)
+{
+	static const EHANDLE none = -1;
+	size_t i, n, n_alive = writing ? world->n_alive : world->n_ents;
+	int err;
+	for (i = 0; i < world->n_ents; i += n) {
+		n = run_length(i, world->n_ents);
+		err = transfer(file, &GET(world, i), n * world->ent_size,
+			writing);
+		if (err) {
+			return err;
+		}
+	}
+	for (i = 0; i < world->n_ents && world->extra_size > 0; i += n) {
+		n = run_length(i, world->n_ents);
+		err = transfer(file, EXTRA(world, i), n * world->extra_size,
+			writing);
+		if (err) {
+			return err;
+		}
+	}
+	for (i = 0; i < n_alive; i += n) {
+		n = run_length(i, n_alive);
+		err = transfer(file, &ALIVE(world, i), n * sizeof(EHANDLE),
+			writing);
+		if (err) {
+			return err;
+		}
+	}
+	/* Pad the list so that the entities can be used as a buffer as is. */
+	for (; i < world->n_ents; ++i) {
+		err = transfer(file, (void *)&none, sizeof(none), 1);
+		if (err) {
+			return err;
+		}
+	}
+	return 0;
+}
+
+int jwb_world_save(WORLD *world, FILE *file)
+{
+	static const char zeros[8] = {0};
+	struct snapshot snap;
+	size_t n_cells;
+	int err;
+	if (!file) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	n_cells = world->width * world->height;
+	memset(&snap, 0, sizeof(snap));
+	fill_layout(&snap);
+	snap.ent_size = world->ent_size;
+	snap.extra_size = world->extra_size;
+	snap.ent_extra = jwb_world_extra_size(world);
+	snap.width = jwb_world_get_width(world);
+	snap.height = jwb_world_get_height(world);
+	snap.n_ents = world->n_ents;
+	snap.n_alive = world->n_alive;
+	snap.freed = world->freed;
+	snap.available = world->available;
+	snap.tracking = world->tracking;
+	snap.regrid_interval = world->regrid_interval;
+	snap.regrid_countdown = world->regrid_countdown;
+	snap.flags = world->flags & ~(PROVIDED_ENT_BUF | PROVIDED_CELL_BUF);
+	snap.cell_size = jwb_world_get_cell_size(world);
+	snap.offset = world->offset;
+	snap.gravity = world->gravity;
+	snap.friction = world->friction;
+	snap.damping = world->damping;
+	if ((err = transfer(file, &snap, sizeof(snap), 1))
+	 || (err = transfer(file, (void *)zeros,
+		CELLS_OFFSET - sizeof(snap), 1))
+	 || (err = transfer(file, world->cells, n_cells * sizeof(EHANDLE), 1))
+	 || (err = transfer(file, (void *)zeros,
+		ents_offset(&snap) - CELLS_OFFSET - n_cells * sizeof(EHANDLE),
+		1))
+	 || (err = transfer_ents(world, file, 1))) {
+		return err;
+	}
+	return fflush(file) ? -JWBE_IO : 0;
+}
+
+int jwb_world_load(
+	WORLD *world,
+	FILE *file,
+	const struct jwb_allocator *allocator)
+{
+	char padding[8];
+	struct snapshot snap;
+	size_t n_cells;
+	int err;
+	if (!file) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	if ((err = transfer(file, &snap, sizeof(snap), 0))
+	 || (err = check_snapshot(&snap))
+	 || (err = transfer(file, padding, CELLS_OFFSET - sizeof(snap), 0))
+	 || (err = alloc_from(world, &snap, allocator, NULL, NULL))) {
+		return err;
+	}
+	n_cells = world->width * world->height;
+	if ((err = transfer(file, world->cells, n_cells * sizeof(EHANDLE), 0))
+	 || (err = transfer(file, padding, ents_offset(&snap) - CELLS_OFFSET
+		- n_cells * sizeof(EHANDLE), 0))
+	 || (err = transfer_ents(world, file, 0))
+	 || (err = check_handles(world))) {
+		jwb_world_destroy(world);
+		return err;
+	}
+	return 0;
+}
+
+int jwb_world_load_mapped(
+	WORLD *world,
+	void *data,
+	size_t size,
+	const struct jwb_allocator *allocator)
+{
+	struct snapshot snap;
+	int err;
+#ifdef JWBO_PAGED_ENTS
+	(void)world;
+	(void)data;
+	(void)size;
+	(void)allocator;
+	(void)snap;
+	(void)err;
+	return -JWBE_INVALID_ARGUMENT;
+#else
+	if (!data) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	if (size < sizeof(snap)) {
+		return -JWBE_BAD_SNAPSHOT;
+	}
+	memcpy(&snap, data, sizeof(snap));
+	if ((err = check_snapshot(&snap))) {
+		return err;
+	}
+	if (size < snapshot_size(&snap)) {
+		return -JWBE_BAD_SNAPSHOT;
+	}
+	err = alloc_from(world, &snap, allocator,
+		(char *)data + ents_offset(&snap),
+		(char *)data + CELLS_OFFSET);
+	if (!err && (err = check_handles(world))) {
+		jwb_world_destroy(world);
+	}
+	return err;
+#endif
+}
@@ -4,11 +4,13 @@
 #include <stdlib.h>
 #include <string.h>
 
-/* Put a number inside the range [0, lim). fframe(12, 5) is 2, while
- * fframe(-12, 5) is 3. */
-static jwb_num_t fframe(jwb_num_t num, jwb_num_t lim)
+jwb_num_t jwb__fframe(jwb_num_t num, jwb_num_t lim)
 {
+#ifdef JWBO_NUM_FIXED
+	jwb_num_t mod = num % lim;
+#else
 	jwb_num_t mod = fmod(num, lim);
+#endif
 	if (mod < 0) {
 		mod += lim;
 	}
@@ -19,24 +21,8 @@ static jwb_num_t fframe(jwb_num_t num, jwb_num_t lim)
  * memory failures. */
 static EHANDLE alloc_new_ent(WORLD *world)
 {
-	if (world->n_ents >= world->ent_cap) {
-#ifdef JWBO_NO_ALLOC
+	if (jwb__reserve_ents(world, world->n_ents + 1)) {
 		return -JWBE_NO_MEMORY;
-#else
-		size_t new_cap;
-		char *new_buf;
-		if (world->flags & PROVIDED_ENT_BUF) {
-			return -JWBE_NO_MEMORY;
-		}
-		new_cap = world->ent_cap * 3 / 2 + 1;
-		new_buf = realloc(world->ents, new_cap * world->ent_size);
-		if (new_buf) {
-			world->ents = new_buf;
-			world->ent_cap = new_cap;
-		} else {
-			return -JWBE_NO_MEMORY;
-		}
-#endif /* JWBO_NO_ALLOC */
 	}
 	return world->n_ents++;
 }
@@ -66,6 +52,9 @@ static void link_dead(WORLD *world, EHANDLE ent, EHANDLE *list)
 {
 	GET(world, ent).last = -1;
 	GET(world, ent).next = *list;
+	if (*list >= 0) {
+		GET(world, *list).last = ent;
+	}
 	*list = ent;
 }
 
@@ -91,7 +80,7 @@ static void unlink_living(WORLD *world, EHANDLE ent)
 static void link_living(WORLD *world, EHANDLE ent, size_t cell_idx)
 {
 	EHANDLE cell = world->cells[cell_idx];
-	GET(world, ent).last = ~cell_idx;
+	GET(world, ent).last = ~(EHANDLE)cell_idx;
 	GET(world, ent).next = cell;
 	if (cell >= 0) {
 		GET(world, cell).last = ent;
@@ -99,10 +88,32 @@ static void link_living(WORLD *world, EHANDLE ent, size_t cell_idx)
 	world->cells[cell_idx] = ent;
 }
 
+/* Add an entity to the end of the dense list of living ones. Unchecked. */
+static void link_dense(WORLD *world, EHANDLE ent)
+{
+	GET(world, ent).dense = world->n_alive;
+	ALIVE(world, world->n_alive) = ent;
+	++world->n_alive;
+}
+
+/* Take an entity out of the dense list by moving the last one into its place.
+ * The entity keeps its old index so that iteration can continue from it. */
+static void unlink_dense(WORLD *world, EHANDLE ent)
+{
+	EHANDLE moved;
+	size_t idx = GET(world, ent).dense;
+	--world->n_alive;
+	moved = ALIVE(world, world->n_alive);
+	ALIVE(world, idx) = moved;
+	GET(world, moved).dense = idx;
+	GET(world, ent).dense = idx;
+}
+
 /* Remove a living entity and put it into the `freed` list. Unchecked. */
 static void remove_unck(WORLD *world, EHANDLE ent)
 {
 	unlink_living(world, ent);
+	unlink_dense(world, ent);
 	link_dead(world, ent, &world->freed);
 	GET(world, ent).flags |= REMOVED;
 }
@@ -123,8 +134,8 @@ static size_t reposition(WORLD *world, EHANDLE ent)
 	pos = GET(world, ent).pos;
 	pos.x -= world->offset.x;
 	pos.y -= world->offset.y;
-	pos.x = fframe(pos.x, world->width * world->cell_size);
-	pos.y = fframe(pos.y, world->height * world->cell_size);
+	pos.x = jwb__fframe(pos.x, (jwb_num_t)world->width * world->cell_size);
+	pos.y = jwb__fframe(pos.y, (jwb_num_t)world->height * world->cell_size);
 	pos_to_idx(world, &pos, &x, &y);
 	pos.x += world->offset.x;
 	pos.y += world->offset.y;
@@ -147,38 +158,145 @@ static size_t reposition_nowrap(WORLD *world, EHANDLE ent)
 	return y * world->width + x;
 }
 
-/* Place an entity where its position dictates. Assumes that it is not alive;
- * unchecked. */
-static void place_ent(WORLD *world, EHANDLE ent)
+/* Bounce one coordinate off the walls at 0 and lim, taking the radius into
+ * account. The velocity is turned to point away from the wall which was hit. */
+static void reflect(jwb_num_t *pos, jwb_num_t *vel, jwb_num_t radius,
+	jwb_num_t lim)
 {
-	size_t cell;
-	if (REMOVING_DISTANT(world)) {
-		cell = reposition_nowrap(world, ent);
-		if (cell == (size_t)-1) {
-			return;
+	jwb_num_t low, high;
+	low = radius;
+	high = lim - radius;
+	if (*pos < low) {
+		*pos = low + (low - *pos);
+		if (*vel < 0.) {
+			*vel = -*vel;
 		}
+	} else if (*pos > high) {
+		*pos = high - (*pos - high);
+		if (*vel > 0.) {
+			*vel = -*vel;
+		}
+	}
+	/* The entity overshot by more than the width of the world. */
+	if (*pos < low) {
+		*pos = low;
+	} else if (*pos > high) {
+		*pos = high;
+	}
+}
+
+/* Same as `reposition`, but for walled worlds. Entities which have gone past
+ * the edges are reflected back inside. */
+static size_t reposition_walled(WORLD *world, EHANDLE ent)
+{
+	size_t x, y;
+	struct jwb__entity *self;
+	VECT pos;
+	self = &GET(world, ent);
+	pos = self->pos;
+	pos.x -= world->offset.x;
+	pos.y -= world->offset.y;
+	reflect(&pos.x, &self->vel.x, self->radius,
+		(jwb_num_t)world->width * world->cell_size);
+	reflect(&pos.y, &self->vel.y, self->radius,
+		(jwb_num_t)world->height * world->cell_size);
+	pos_to_idx(world, &pos, &x, &y);
+	if (x >= world->width) {
+		x = world->width - 1;
+	}
+	if (y >= world->height) {
+		y = world->height - 1;
+	}
+	pos.x += world->offset.x;
+	pos.y += world->offset.y;
+	self->pos = pos;
+	return y * world->width + x;
+}
+
+/* Get the cell in which to place an entity, moving it inside the grid if
+ * necessary. Returns -1 if it is off the grid of a world which removes distant
+ * entities. */
+static size_t find_cell(WORLD *world, EHANDLE ent)
+{
+	if (REMOVING_DISTANT(world)) {
+		return reposition_nowrap(world, ent);
+	} else if (WALLED(world)) {
+		return reposition_walled(world, ent);
 	} else {
-		cell = reposition(world, ent);
+		return reposition(world, ent);
+	}
+}
+
+/* Link an entity into the cell gotten from `find_cell`. Assumes that it is not
+ * alive and not in any list; unchecked. An entity placed off the grid of a
+ * world which removes distant entities is put in the `freed` list. */
+static void link_placed(WORLD *world, EHANDLE ent, size_t cell)
+{
+	if (cell == (size_t)-1) {
+		link_dead(world, ent, &world->freed);
+		GET(world, ent).flags |= REMOVED;
+		return;
 	}
 	link_living(world, ent, cell);
+	link_dense(world, ent);
+}
+
+/* Place an entity where its position dictates. See `link_placed`. */
+static void place_ent(WORLD *world, EHANDLE ent)
+{
+	link_placed(world, ent, find_cell(world, ent));
+}
+
+/* Invoke the hit handler and record the hit with the impulse it applied. */
+static void record_hit(WORLD *world, EHANDLE ent1, EHANDLE ent2,
+	struct jwb_hit_info *info)
+{
+	struct jwb_hit_info copy = *info;
+	jwb_num_t impulse = 0;
+	VECT vel;
+	vel = GET(world, ent2).vel;
+	world->on_hit(world, ent1, ent2, info);
+	if (copy.dist > 0) {
+		vel.x = GET(world, ent2).vel.x - vel.x;
+		vel.y = GET(world, ent2).vel.y - vel.y;
+		impulse = MUL(GET(world, ent2).mass, DIV(MUL(vel.x, copy.rel.x)
+			+ MUL(vel.y, copy.rel.y), copy.dist));
+	}
+	jwb__record_contact(world, ent1, ent2, &copy, impulse);
 }
 
 /* Invoke the hit handler if two entities are touching. */
 static void check_hit(WORLD *world, EHANDLE ent1, EHANDLE ent2)
 {
 	struct jwb_hit_info info;
+	if (!(GET(world, ent1).category & GET(world, ent2).mask)
+	 || !(GET(world, ent2).category & GET(world, ent1).mask)) {
+		return;
+	}
 	info.rel.x = GET(world, ent2).pos.x - GET(world, ent1).pos.x;
 	info.rel.y = GET(world, ent2).pos.y - GET(world, ent1).pos.y;
 	info.dist = jwb_vect_magnitude(&info.rel);
 	if (info.dist < GET(world, ent1).radius + GET(world, ent2).radius) {
-		world->on_hit(world, ent1, ent2, &info);
+		if (TRACKING_CONTACTS(world)) {
+			jwb__touch_contact(world, ent1, ent2);
+		}
+		if (world->recording) {
+			record_hit(world, ent1, ent2, &info);
+		} else {
+			world->on_hit(world, ent1, ent2, &info);
+		}
 	}
 }
 
 /* Check the collisions of all entities within one cell. */
 static void update_cell(WORLD *world, size_t x, size_t y)
 {
-	EHANDLE next = world->cells[y * world->width + x];
+	size_t cell = y * world->width + x;
+	EHANDLE next = world->cells[cell];
+	if (world->cell_filtering && !(world->cell_filters[cell * 2]
+	                               & world->cell_filters[cell * 2 + 1])) {
+		return;
+	}
 	while (next >= 0) {
 		EHANDLE self, next_other;
 		self = next;
@@ -202,9 +320,17 @@ static void update_cells(
 	size_t x2,
 	size_t y2)
 {
+	size_t cell1 = y1 * world->width + x1, cell2 = y2 * world->width + x2;
 	EHANDLE next1, next2;
-	next1 = world->cells[y1 * world->width + x1];
-	next2 = world->cells[y2 * world->width + x2];
+	if (world->cell_filtering) {
+		const unsigned *filters = world->cell_filters;
+		if (!(filters[cell1 * 2] & filters[cell2 * 2 + 1])
+		 || !(filters[cell2 * 2] & filters[cell1 * 2 + 1])) {
+			return;
+		}
+	}
+	next1 = world->cells[cell1];
+	next2 = world->cells[cell2];
 	while (next1 >= 0) {
 		EHANDLE self, next_other;
 		self = next1;
@@ -219,10 +345,57 @@ static void update_cells(
 	}
 }
 
+/* Information about one step which is the same for all entities. */
+struct step_info {
+	jwb_num_t dt;
+	VECT accel; /* Gravity over dt. */
+	jwb_num_t damp; /* Scale for velocity due to damping. */
+	jwb_num_t friction; /* Friction over dt. */
+	int integrating; /* Whether any of the above three do anything. */
+};
+
+/* Calculate the constants used when moving entities by the time dt. */
+static void get_step_info(WORLD *world, jwb_num_t dt, struct step_info *info)
+{
+	info->dt = dt;
+	info->accel.x = MUL(world->gravity.x, dt);
+	info->accel.y = MUL(world->gravity.y, dt);
+	info->damp = NUM(1) - MUL(world->damping, dt);
+	if (info->damp < 0.) {
+		info->damp = 0.;
+	}
+	info->friction = MUL(world->friction, dt);
+	info->integrating = info->accel.x != 0. || info->accel.y != 0.
+		|| info->damp != NUM(1) || info->friction > 0.;
+}
+
+/* Apply world-wide acceleration, damping, and friction to a velocity. */
+static void integrate(VECT *vel, const struct step_info *info)
+{
+	vel->x += info->accel.x;
+	vel->y += info->accel.y;
+	vel->x = MUL(vel->x, info->damp);
+	vel->y = MUL(vel->y, info->damp);
+	if (info->friction > 0.) {
+		jwb_num_t speed, ratio;
+		speed = jwb_vect_magnitude(vel);
+		if (speed > info->friction) {
+			ratio = DIV(speed - info->friction, speed);
+			vel->x = MUL(vel->x, ratio);
+			vel->y = MUL(vel->y, ratio);
+		} else {
+			vel->x = 0.;
+			vel->y = 0.;
+		}
+	}
+}
+
 /* Put all entities in their appropriate places according to their position
- * after factoring in velocity and correctional displacement (used to keep
- * collided entities from overlapping.) */
-static void move_ents(WORLD *world, size_t x, size_t y)
+ * after factoring in velocity over the time dt and correctional displacement
+ * (used to keep collided entities from overlapping.) Velocities are then
+ * integrated for the next step. */
+static void move_ents(WORLD *world, size_t x, size_t y,
+	const struct step_info *info)
 {
 	size_t here = y * world->width + x;
 	EHANDLE next = world->cells[here];
@@ -235,18 +408,23 @@ static void move_ents(WORLD *world, size_t x, size_t y)
 			GET(world, self).flags &= ~MOVED_THIS_STEP;
 			continue;
 		}
-		GET(world, self).pos.x += GET(world, self).vel.x
+		GET(world, self).pos.x += MUL(GET(world, self).vel.x, info->dt)
 			+ GET(world, self).correct.x;
-		GET(world, self).pos.y += GET(world, self).vel.y
+		GET(world, self).pos.y += MUL(GET(world, self).vel.y, info->dt)
 			+ GET(world, self).correct.y;
 		GET(world, self).correct.x = 0.;
 		GET(world, self).correct.y = 0.;
+		if (info->integrating) {
+			integrate(&GET(world, self).vel, info);
+		}
 		if (REMOVING_DISTANT(world)) {
 			cell = reposition_nowrap(world, self);
 			if (cell == (size_t)-1) {
 				remove_unck(world, self);
 				continue;
 			}
+		} else if (WALLED(world)) {
+			cell = reposition_walled(world, self);
 		} else {
 			cell = reposition(world, self);
 		}
@@ -292,7 +470,7 @@ static void cell_translate(WORLD *world, size_t x, size_t y, const VECT *disp)
 static void update_top_left(WORLD *world)
 {
 	VECT wrap_left;
-	wrap_left.x = world->cell_size * world->width;
+	wrap_left.x = world->cell_size * (jwb_num_t)world->width;
 	wrap_left.y = 0.;
 	update_cell(world, 0, 0);
 	update_cells(world, 0, 0, 1, 0);
@@ -322,7 +500,7 @@ static void update_top_right(WORLD *world)
 {
 	VECT wrap_right;
 	size_t x = world->width - 1;
-	wrap_right.x = -world->cell_size * world->width;
+	wrap_right.x = -world->cell_size * (jwb_num_t)world->width;
 	wrap_right.y = 0.;
 	update_cell(world, x, 0);
 	cell_translate(world, x, 0, &wrap_right);
@@ -352,7 +530,7 @@ static void update_left(WORLD *world)
 {
 	VECT wrap_left;
 	size_t y;
-	wrap_left.x = world->cell_size * world->width;
+	wrap_left.x = world->cell_size * (jwb_num_t)world->width;
 	wrap_left.y = 0.;
 	for (y = 1; y < world->height - 1; ++y) {
 		update_cell(world, 0, y);
@@ -361,9 +539,9 @@ static void update_left(WORLD *world)
 		update_cells(world, 0, y, 0, y + 1);
 		cell_translate(world, 0, y, &wrap_left);
 		update_cells(world, 0, y, world->width - 1, y + 1);
-		wrap_left.x *= -1.;
+		wrap_left.x *= -1;
 		cell_translate(world, 0, y, &wrap_left);
-		wrap_left.x *= -1.;
+		wrap_left.x *= -1;
 	}
 }
 
@@ -409,7 +587,7 @@ static void update_right(WORLD *world)
 {
 	VECT wrap_right;
 	size_t x, y;
-	wrap_right.x = -world->cell_size * world->width;
+	wrap_right.x = -world->cell_size * (jwb_num_t)world->width;
 	wrap_right.y = 0.;
 	x = world->width - 1;
 	for (y = 1; y < world->height - 1; ++y) {
@@ -417,9 +595,9 @@ static void update_right(WORLD *world)
 		cell_translate(world, x, y, &wrap_right);
 		update_cells(world, x, y, 0, y);
 		update_cells(world, x, y, 0, y + 1);
-		wrap_right.x *= -1.;
+		wrap_right.x *= -1;
 		cell_translate(world, x, y, &wrap_right);
-		wrap_right.x *= -1.;
+		wrap_right.x *= -1;
 		update_cells(world, x, y, x, y + 1);
 		update_cells(world, x, y, x - 1, y + 1);
 	}
@@ -446,10 +624,10 @@ static void update_bottom_left(WORLD *world)
 {
 	VECT wrap_left, wrap_down;
 	size_t y = world->height - 1;
-	wrap_left.x = world->cell_size * world->width;
+	wrap_left.x = world->cell_size * (jwb_num_t)world->width;
 	wrap_left.y = 0.;
 	wrap_down.x = 0.;
-	wrap_down.y = -world->cell_size * world->height;
+	wrap_down.y = -world->cell_size * (jwb_num_t)world->height;
 	update_cell(world, 0, y);
 	update_cells(world, 0, y, 1, y);
 	cell_translate(world, 0, y, &wrap_down);
@@ -457,9 +635,9 @@ static void update_bottom_left(WORLD *world)
 	update_cells(world, 0, y, 0, 0);
 	cell_translate(world, 0, y, &wrap_left);
 	update_cells(world, 0, y, world->width - 1, 0);
-	wrap_left.x *= -1.;
+	wrap_left.x *= -1;
 	cell_translate(world, 0, y, &wrap_left);
-	wrap_down.y *= -1.;
+	wrap_down.y *= -1;
 	cell_translate(world, 0, y, &wrap_down);
 }
 
@@ -481,7 +659,7 @@ static void update_bottom(WORLD *world)
 	VECT wrap_down;
 	size_t x, y;
 	wrap_down.x = 0.;
-	wrap_down.y = -world->cell_size * world->height;
+	wrap_down.y = -world->cell_size * (jwb_num_t)world->height;
 	y = world->height - 1;
 	for (x = 1; x < world->width - 1; ++x) {
 		update_cell(world, x, y);
@@ -490,9 +668,9 @@ static void update_bottom(WORLD *world)
 		update_cells(world, x, y, x + 1, 0);
 		update_cells(world, x, y, x, 0);
 		update_cells(world, x, y, x - 1, 0);
-		wrap_down.y *= -1.;
+		wrap_down.y *= -1;
 		cell_translate(world, x, y, &wrap_down);
-		wrap_down.y *= -1.;
+		wrap_down.y *= -1;
 	}
 }
 
@@ -516,10 +694,10 @@ static void update_bottom_right(WORLD *world)
 {
 	VECT wrap_right, wrap_down;
 	jwb_num_t x, y;
-	wrap_right.x = -world->cell_size * world->width;
+	wrap_right.x = -world->cell_size * (jwb_num_t)world->width;
 	wrap_right.y = 0.;
 	wrap_down.x = 0.;
-	wrap_down.y = -world->cell_size * world->height;
+	wrap_down.y = -world->cell_size * (jwb_num_t)world->height;
 	x = world->width - 1;
 	y = world->height - 1;
 	update_cell(world, x, y);
@@ -527,18 +705,173 @@ static void update_bottom_right(WORLD *world)
 	update_cells(world, x, y, 0, y);
 	cell_translate(world, x, y, &wrap_down);
 	update_cells(world, x, y, 0, 0);
-	wrap_right.x *= -1.;
+	wrap_right.x *= -1;
 	cell_translate(world, x, y, &wrap_right);
 	update_cells(world, x, y, x, 0);
 	update_cells(world, x, y, x - 1, 0);
-	wrap_down.y *= -1.;
+	wrap_down.y *= -1;
 	cell_translate(world, x, y, &wrap_down);
 }
 
-void jwb_world_step(WORLD *world)
+static void update_bottom_right_nowrap(WORLD *world)
+{
+	update_cell(world, world->width - 1, world->height - 1);
+}
+
+/* Put all living entities into a new grid. The size of the grid must already be
+ * checked, and for one-cell-thick worlds doubled. Entities can only be found
+ * touching in neighbouring cells, so the cells must be at least as big as the
+ * largest diameter. */
+static int regrid(WORLD *world, jwb_num_t cell_size, size_t width,
+	size_t height)
+{
+	size_t i, n_cells;
+	for (i = 0; i < world->n_alive; ++i) {
+		if (2 * GET(world, ALIVE(world, i)).radius > cell_size) {
+			return -JWBE_INVALID_ARGUMENT;
+		}
+	}
+	n_cells = width * height;
+	if (n_cells > world->cell_cap) {
+		EHANDLE *cells;
+		if (world->flags & PROVIDED_CELL_BUF) {
+			return -JWBE_NO_MEMORY;
+		}
+		cells = REALLOC(world, world->cells, n_cells * sizeof(*cells));
+		if (!cells) {
+			return -JWBE_NO_MEMORY;
+		}
+		world->cells = cells;
+		world->cell_cap = n_cells;
+	}
+	for (i = 0; i < n_cells; ++i) {
+		world->cells[i] = -1;
+	}
+	world->cell_size = cell_size;
+	world->width = width;
+	world->height = height;
+	/* Going backwards, removing an entity only moves one already placed. */
+	for (i = world->n_alive; i-- > 0; ) {
+		EHANDLE ent = ALIVE(world, i);
+		size_t cell = find_cell(world, ent);
+		if (cell == (size_t)-1) {
+			unlink_dense(world, ent);
+			link_dead(world, ent, &world->freed);
+			GET(world, ent).flags |= REMOVED;
+		} else {
+			link_living(world, ent, cell);
+		}
+	}
+	return 0;
+}
+
+/* Get how far a cell size is from the target, as the ratio of the larger to
+ * the smaller. */
+static jwb_num_t size_error(jwb_num_t cell_size, jwb_num_t target)
 {
+	return cell_size > target
+		? DIV(cell_size, target) : DIV(target, cell_size);
+}
+
+/* Split or merge cells to bring the cell size closer to the largest diameter,
+ * which is as small as cells can be. */
+static void auto_regrid(WORLD *world)
+{
+	jwb_num_t max_radius, target, best_error;
+	size_t i, k, n_cells, max_cells, best_k;
+	int split;
+	if (world->n_alive == 0) {
+		return;
+	}
+	max_radius = 0.;
+	for (i = 0; i < world->n_alive; ++i) {
+		jwb_num_t radius = GET(world, ALIVE(world, i)).radius;
+		if (radius > max_radius) {
+			max_radius = radius;
+		}
+	}
+	target = 2 * max_radius;
+	n_cells = world->width * world->height;
+	max_cells = world->n_alive * 4 > 64 ? world->n_alive * 4 : 64;
+	best_error = size_error(world->cell_size, target);
+	best_k = 1;
+	split = 0;
+	for (k = 2; world->cell_size / (jwb_num_t)k >= 2 * max_radius
+	         && n_cells * k * k <= max_cells
+	         && world->width * k <= (size_t)EHANDLE_MAX / world->height / k;
+	     ++k) {
+		jwb_num_t error = size_error(world->cell_size / (jwb_num_t)k,
+			target);
+		if (error < best_error) {
+			best_error = error;
+			best_k = k;
+			split = 1;
+		}
+	}
+	/* Each side must stay at least two cells long. */
+	for (k = 2; k <= world->width / 2 && k <= world->height / 2; ++k) {
+		jwb_num_t error;
+		if (world->width % k != 0 || world->height % k != 0) {
+			continue;
+		}
+		error = size_error(world->cell_size * (jwb_num_t)k, target);
+		if (error < best_error) {
+			best_error = error;
+			best_k = k;
+			split = 0;
+		}
+	}
+	if (best_k == 1) {
+		return;
+	}
+	if (split) {
+		regrid(world, world->cell_size / (jwb_num_t)best_k,
+			world->width * best_k, world->height * best_k);
+	} else {
+		regrid(world, world->cell_size * (jwb_num_t)best_k,
+			world->width / best_k, world->height / best_k);
+	}
+}
+
+/* Combine the categories and masks of the entities in each cell, if the world
+ * has the flag for it. Cell filtering is left off if memory runs out. */
+static void gather_cell_filters(WORLD *world)
+{
+	size_t n_cells = world->width * world->height, cell;
+	world->cell_filtering = 0;
+	if (!(world->flags & JWBF_CELL_FILTERS)) {
+		return;
+	}
+	if (world->cell_filters_cap < n_cells) {
+		unsigned *filters = REALLOC(world, world->cell_filters,
+			n_cells * 2 * sizeof(*filters));
+		if (!filters) {
+			return;
+		}
+		world->cell_filters = filters;
+		world->cell_filters_cap = n_cells;
+	}
+	for (cell = 0; cell < n_cells; ++cell) {
+		unsigned categories = 0, masks = 0;
+		EHANDLE ent;
+		for (ent = world->cells[cell]; ent >= 0;
+		     ent = GET(world, ent).next) {
+			categories |= GET(world, ent).category;
+			masks |= GET(world, ent).mask;
+		}
+		world->cell_filters[cell * 2] = categories;
+		world->cell_filters[cell * 2 + 1] = masks;
+	}
+	world->cell_filtering = 1;
+}
+
+/* Step the world forward by the time dt. */
+static void step(WORLD *world, jwb_num_t dt)
+{
+	struct step_info info;
 	size_t x, y;
-	if (REMOVING_DISTANT(world)) {
+	gather_cell_filters(world);
+	if (REMOVING_DISTANT(world) || WALLED(world)) {
 		if (world->width == 1) {
 			update_cell(world, 0, 0);
 			for (y = 1; y < world->height; ++y) {
@@ -547,7 +880,7 @@ void jwb_world_step(WORLD *world)
 			}
 		} else if (world->height == 1) {
 			update_cell(world, 0, 0);
-			for (x = 1; x < world->height; ++x) {
+			for (x = 1; x < world->width; ++x) {
 				update_cells(world, x - 1, 0, x, 0);
 				update_cell(world, x, 0);
 			}
@@ -559,6 +892,7 @@ void jwb_world_step(WORLD *world)
 			update_right_nowrap(world);
 			update_bottom_left_nowrap(world);
 			update_bottom_nowrap(world);
+			update_bottom_right_nowrap(world);
 		}
 	} else {
 		update_top_left(world);
@@ -570,20 +904,56 @@ void jwb_world_step(WORLD *world)
 		update_bottom(world);
 		update_bottom_right(world);
 	}
+	if (TRACKING_CONTACTS(world)) {
+		jwb__end_contacts(world);
+	}
 	if (world->tracking >= 0) {
 		struct jwb__entity *tracked = &GET(world, world->tracking);
 		if (tracked->flags & REMOVED) {
 			world->tracking = -1;
 		} else {
-			world->offset.x += tracked->correct.x + tracked->vel.x;
-			world->offset.y += tracked->correct.y + tracked->vel.y;
+			world->offset.x += tracked->correct.x
+				+ MUL(tracked->vel.x, dt);
+			world->offset.y += tracked->correct.y
+				+ MUL(tracked->vel.y, dt);
 		}
 	}
+	get_step_info(world, dt, &info);
 	for (y = 0; y < world->height; ++y) {
 		for (x = 0; x < world->width; ++x) {
-			move_ents(world, x, y);
+			move_ents(world, x, y, &info);
 		}
 	}
+	if (world->regrid_interval > 0 && --world->regrid_countdown == 0) {
+		world->regrid_countdown = world->regrid_interval;
+		auto_regrid(world);
+	}
+}
+
+void jwb_world_step(WORLD *world)
+{
+	world->n_recorded = 0;
+	step(world, NUM(1));
+	if (world->recorder) {
+		jwb__record_frame(world);
+	}
+}
+
+int jwb_world_step_dt(WORLD *world, jwb_num_t dt, unsigned substeps)
+{
+	unsigned i;
+	if (dt < 0. || substeps == 0) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	dt /= substeps;
+	world->n_recorded = 0;
+	for (i = 0; i < substeps; ++i) {
+		step(world, dt);
+	}
+	if (world->recorder) {
+		jwb__record_frame(world);
+	}
+	return 0;
 }
 
 EHANDLE jwb_world_add_ent(WORLD *world,
@@ -608,16 +978,120 @@ EHANDLE jwb_world_add_ent(WORLD *world,
 	GET(world, ent).correct.y = 0.;
 	GET(world, ent).mass = mass;
 	GET(world, ent).radius = radius;
+	GET(world, ent).category = 1;
+	GET(world, ent).mask = ~0U;
 	GET(world, ent).flags = 0;
 	place_ent(world, ent);
 	return ent;
 }
 
+int jwb_world_add_ents(WORLD *world,
+	size_t num,
+	const VECT *pos,
+	const VECT *vel,
+	const jwb_num_t *mass,
+	const jwb_num_t *radius,
+	EHANDLE *handles)
+{
+	EHANDLE ent, prev, *order;
+	size_t i, n_reused, n_placed, lo, hi, span, *starts;
+	/* Count how many handles can be reused so that the buffer can be grown
+	 * once up front. */
+	n_reused = 0;
+	for (ent = world->available; ent >= 0 && n_reused < num;
+	     ent = GET(world, ent).next) {
+		++n_reused;
+	}
+	if (jwb__reserve_ents(world, world->n_ents + (num - n_reused))) {
+		return -JWBE_NO_MEMORY;
+	}
+	/* Set up every entity first, keeping its cell in `next` and chaining
+	 * them together backwards through `last`. Those off the grid are put
+	 * away right away. */
+	prev = -1;
+	n_placed = 0;
+	lo = (size_t)-1;
+	hi = 0;
+	for (i = 0; i < num; ++i) {
+		size_t cell;
+		if (world->available >= 0) {
+			ent = world->available;
+			unlink_dead(world, ent, &world->available);
+		} else {
+			ent = world->n_ents++;
+		}
+		GET(world, ent).pos = pos[i];
+		GET(world, ent).vel = vel[i];
+		GET(world, ent).correct.x = 0.;
+		GET(world, ent).correct.y = 0.;
+		GET(world, ent).mass = mass[i];
+		GET(world, ent).radius = radius[i];
+		GET(world, ent).category = 1;
+		GET(world, ent).mask = ~0U;
+		GET(world, ent).flags = 0;
+		if (handles) {
+			handles[i] = ent;
+		}
+		cell = find_cell(world, ent);
+		if (cell == (size_t)-1) {
+			link_placed(world, ent, cell);
+			continue;
+		}
+		GET(world, ent).next = cell;
+		GET(world, ent).last = prev;
+		prev = ent;
+		++n_placed;
+		if (cell < lo) {
+			lo = cell;
+		}
+		if (cell > hi) {
+			hi = cell;
+		}
+	}
+	/* Then link them in by cell with a counting sort, so that each cell is
+	 * filled in one go and the alive list follows the grid. Entities spread
+	 * much thinner than one per cell have little to gain from this. They
+	 * are linked in unsorted, as they are if there is no memory to sort. */
+	starts = NULL;
+	span = hi - lo + 1;
+	if (n_placed > 1 && span <= 4 * n_placed) {
+		starts = ALLOC(world, (span + 1) * sizeof(*starts)
+			+ n_placed * sizeof(*order));
+	}
+	if (!starts) {
+		for (ent = prev; ent >= 0; ent = prev) {
+			size_t cell = GET(world, ent).next;
+			prev = GET(world, ent).last;
+			link_placed(world, ent, cell);
+		}
+		return 0;
+	}
+	order = (EHANDLE *)(starts + span + 1);
+	memset(starts, 0, (span + 1) * sizeof(*starts));
+	for (ent = prev; ent >= 0; ent = GET(world, ent).last) {
+		++starts[GET(world, ent).next - lo + 1];
+	}
+	for (i = 1; i <= span; ++i) {
+		starts[i] += starts[i - 1];
+	}
+	/* The chain runs backwards, so each cell's run is filled from its end
+	 * to keep the entities in the order given. */
+	for (ent = prev; ent >= 0; ent = GET(world, ent).last) {
+		order[--starts[GET(world, ent).next - lo + 1]] = ent;
+	}
+	for (i = 0; i < n_placed; ++i) {
+		link_placed(world, order[i], GET(world, order[i]).next);
+	}
+	FREE(world, starts);
+	return 0;
+}
+
 int jwb_world_re_add_ent(WORLD *world, EHANDLE ent)
 {
 	int err = jwb_world_confirm_ent(world, ent);
 	switch (-err) {
 	case JWBE_REMOVED_ENTITY:
+		unlink_dead(world, ent, &world->freed);
 		GET(world, ent).flags &= ~REMOVED;
 		place_ent(world, ent);
 		return 0;
@@ -644,6 +1118,7 @@ int jwb_world_destroy_ent(WORLD *world, EHANDLE ent)
 	switch (-status) {
 	case 0:
 		unlink_living(world, ent);
+		unlink_dense(world, ent);
 		break;
 	case JWBE_REMOVED_ENTITY:
 		unlink_dead(world, ent, &world->freed);
@@ -656,10 +1131,174 @@ int jwb_world_destroy_ent(WORLD *world, EHANDLE ent)
 	return 0;
 }
 
+int jwb_world_remove_ents(WORLD *world, size_t num, const EHANDLE *ents)
+{
+	int ret = 0;
+	size_t i;
+	for (i = 0; i < num; ++i) {
+		int status = jwb_world_remove_ent(world, ents[i]);
+		if (status && !ret) {
+			ret = status;
+		}
+	}
+	return ret;
+}
+
+int jwb_world_destroy_ents(WORLD *world, size_t num, const EHANDLE *ents)
+{
+	int ret = 0;
+	size_t i;
+	for (i = 0; i < num; ++i) {
+		int status = jwb_world_destroy_ent(world, ents[i]);
+		if (status && !ret) {
+			ret = status;
+		}
+	}
+	return ret;
+}
+
+int jwb_world_regrid(WORLD *world, jwb_num_t cell_size, size_t width,
+	size_t height)
+{
+	int err;
+	int one_cell_thick = 0;
+	if (width == 0 || height == 0 || cell_size <= 0.
+	 || width > (size_t)EHANDLE_MAX / height / 4) {
+		return -JWBE_INVALID_ARGUMENT;
+	}
+	if (width == 1 || height == 1) {
+		one_cell_thick = 1;
+		width *= 2;
+		height *= 2;
+		cell_size /= 2;
+	}
+	err = regrid(world, cell_size, width, height);
+	if (err) {
+		return err;
+	}
+	if (one_cell_thick) {
+		world->flags |= ONE_CELL_THICK;
+	} else {
+		world->flags &= ~ONE_CELL_THICK;
+	}
+	return 0;
+}
+
+void jwb_world_auto_regrid(WORLD *world, unsigned interval)
+{
+	world->regrid_interval = interval;
+	world->regrid_countdown = interval;
+}
+
+/* Swap two blocks of memory of the same size. */
+static void swap_bytes(char *mem1, char *mem2, size_t size)
+{
+	char tmp[64];
+	size_t left;
+	for (left = size; left > 0; ) {
+		size_t chunk = left < sizeof(tmp) ? left : sizeof(tmp);
+		memcpy(tmp, mem1, chunk);
+		memcpy(mem1, mem2, chunk);
+		memcpy(mem2, tmp, chunk);
+		mem1 += chunk;
+		mem2 += chunk;
+		left -= chunk;
+	}
+}
+
+/* Swap the records of two entities, along with any out-of-line extra data. */
+static void swap_ents(WORLD *world, EHANDLE ent1, EHANDLE ent2)
+{
+	swap_bytes((char *)&GET(world, ent1), (char *)&GET(world, ent2),
+		world->ent_size);
+	swap_bytes(EXTRA(world, ent1), EXTRA(world, ent2), world->extra_size);
+}
+
+/* Give an entity its new handle for compaction. The new handle is stored in
+ * `last` and the list the entity belongs to (a cell index, or -1 for `freed`)
+ * is stored in `next`. Returns the next entity in the original list. */
+static EHANDLE assign_handle(
+	WORLD *world,
+	EHANDLE ent,
+	EHANDLE new_ent,
+	EHANDLE list,
+	EHANDLE *remap)
+{
+	EHANDLE next = GET(world, ent).next;
+	GET(world, ent).next = list;
+	GET(world, ent).last = new_ent;
+	if (remap) {
+		remap[ent] = GET(world, ent).flags & DESTROYED ? -1 : new_ent;
+	}
+	return next;
+}
+
+void jwb_world_compact(WORLD *world, EHANDLE *remap)
+{
+	EHANDLE e, new_ent;
+	size_t cell, n_cells, n_kept;
+	n_cells = world->width * world->height;
+	new_ent = 0;
+	for (cell = 0; cell < n_cells; ++cell) {
+		e = world->cells[cell];
+		while (e >= 0) {
+			e = assign_handle(world, e, new_ent++, cell, remap);
+		}
+	}
+	e = world->freed;
+	while (e >= 0) {
+		e = assign_handle(world, e, new_ent++, -1, remap);
+	}
+	n_kept = new_ent;
+	e = world->available;
+	while (e >= 0) {
+		e = assign_handle(world, e, new_ent++, -1, remap);
+	}
+	if (world->tracking >= 0) {
+		world->tracking = GET(world, world->tracking).last;
+	}
+	if (TRACKING_CONTACTS(world)) {
+		jwb__remap_contacts(world);
+	}
+	/* Recorded contacts would have stale handles. */
+	world->n_recorded = 0;
+	if (world->recorder) {
+		jwb__restart_frames(world);
+	}
+	/* Each swap puts one record in its final place. */
+	for (e = 0; e < (EHANDLE)world->n_ents; ++e) {
+		while (GET(world, e).last != e) {
+			swap_ents(world, e, GET(world, e).last);
+		}
+	}
+	world->n_ents = n_kept;
+	for (cell = 0; cell < n_cells; ++cell) {
+		world->cells[cell] = -1;
+	}
+	world->freed = -1;
+	world->available = -1;
+	/* The living entities now come first. */
+	world->n_alive = 0;
+	for (e = 0; e < (EHANDLE)n_kept; ++e) {
+		if (GET(world, e).next >= 0) {
+			link_dense(world, e);
+		}
+	}
+	/* Link backwards so that the lists end up in order of handle. */
+	for (e = n_kept - 1; e >= 0; --e) {
+		EHANDLE list = GET(world, e).next;
+		if (list >= 0) {
+			link_living(world, e, list);
+		} else {
+			link_dead(world, e, &world->freed);
+		}
+	}
+}
+
 int jwb_world_confirm_ent(WORLD *world, EHANDLE ent)
 {
 	int flags;
-	if (ent >= (long)world->n_ents) {
+	if (ent >= (EHANDLE)world->n_ents) {
 		return -JWBE_DESTROYED_ENTITY;
 	}
 	flags = GET(world, ent).flags;
@@ -21,13 +21,13 @@ void jwb_no_overlap(
 	struct jwb__entity *info1, *info2;
 	info1 = &GET(world, ent1);
 	info2 = &GET(world, ent2);
-	overlap = 1. - info->dist / (info1->radius + info2->radius);
-	cor1 = -overlap / (info1->mass / info2->mass + 1.);
+	overlap = NUM(1) - DIV(info->dist, info1->radius + info2->radius);
+	cor1 = DIV(-overlap, DIV(info1->mass, info2->mass) + NUM(1));
 	cor2 = cor1 + overlap;
-	info1->correct.x += info->rel.x * cor1;
-	info1->correct.y += info->rel.y * cor1;
-	info2->correct.x += info->rel.x * cor2;
-	info2->correct.y += info->rel.y * cor2;
+	info1->correct.x += MUL(info->rel.x, cor1);
+	info1->correct.y += MUL(info->rel.y, cor1);
+	info2->correct.x += MUL(info->rel.x, cor2);
+	info2->correct.y += MUL(info->rel.y, cor2);
 }
 
 void jwb_elastic_collision(
@@ -49,8 +49,8 @@ void jwb_elastic_collision(
 	vel2 = GET(world, ent2).vel;
 	jwb_vect_rotate(&vel1, &rot);
 	jwb_vect_rotate(&vel2, &rot);
-	bounced1 = (mass1 - mass2) / (mass1 + mass2) * vel1.x + 2 * mass2
-		/ (mass1 + mass2) * vel2.x;
+	bounced1 = MUL(DIV(mass1 - mass2, mass1 + mass2), vel1.x)
+		+ MUL(DIV(2 * mass2, mass1 + mass2), vel2.x);
 	bounced2 = vel1.x - vel2.x + bounced1;
 	vel1.x = bounced1;
 	vel2.x = bounced2;
@@ -81,7 +81,7 @@ void jwb_inelastic_collision(
 	vel2 = GET(world, ent2).vel;
 	jwb_vect_rotate(&vel1, &rot);
 	jwb_vect_rotate(&vel2, &rot);
-	smashed = (mass1 * vel1.x + mass2 * vel2.x) / (mass1 + mass2);
+	smashed = DIV(MUL(mass1, vel1.x) + MUL(mass2, vel2.x), mass1 + mass2);
 	vel1.x = smashed;
 	vel2.x = smashed;
 	jwb_rotation_flip(&rot);
@@ -98,10 +98,10 @@ static int apply_friction(WORLD *world, EHANDLE ent, jwb_num_t friction)
 	jwb_num_t speed, ratio;
 	vel = &GET(world, ent).vel;
 	speed = jwb_vect_magnitude(vel);
-	ratio = (speed - friction) / speed;
-	if (ratio > 0.) {
-		vel->x *= ratio;
-		vel->y *= ratio;
+	if (speed > friction) {
+		ratio = DIV(speed - friction, speed);
+		vel->x = MUL(vel->x, ratio);
+		vel->y = MUL(vel->y, ratio);
 	} else {
 		vel->x = 0.;
 		vel->y = 0.;
@@ -111,8 +111,21 @@ static int apply_friction(WORLD *world, EHANDLE ent, jwb_num_t friction)
 
 void jwb_world_apply_friction(WORLD *world, jwb_num_t friction)
 {
-	EHANDLE e;
-	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
-		apply_friction(world, e, friction);
+	jwb_world_apply_friction_dt(world, friction, NUM(1));
+}
+
+void jwb_world_apply_friction_dt(
+	WORLD *world,
+	jwb_num_t friction,
+	jwb_num_t dt)
+{
+	const EHANDLE *handles;
+	size_t i, n, start;
+	friction = MUL(friction, dt);
+	for (start = 0; (n = jwb_world_living(world, start, &handles)) > 0;
+	     start += n) {
+		for (i = 0; i < n; ++i) {
+			apply_friction(world, handles[i], friction);
+		}
 	}
 }
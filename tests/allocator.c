@@ -0,0 +1,90 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 500
+
+/* Counts the blocks currently allocated. */
+struct counter {
+	long blocks;
+	long calls;
+};
+
+static void *count_alloc(void *ctx, size_t size)
+{
+	struct counter *counter = ctx;
+	++counter->blocks;
+	++counter->calls;
+	return malloc(size);
+}
+
+static void *count_realloc(void *ctx, void *ptr, size_t size)
+{
+	struct counter *counter = ctx;
+	if (!ptr) {
+		++counter->blocks;
+	}
+	++counter->calls;
+	return realloc(ptr, size);
+}
+
+static void count_free(void *ctx, void *ptr)
+{
+	struct counter *counter = ctx;
+	if (ptr) {
+		--counter->blocks;
+	}
+	free(ptr);
+}
+
+static void fill(jwb_world_t *world, size_t num)
+{
+	size_t i;
+	for (i = 0; i < num; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., 1.) >= 0);
+	}
+}
+
+int main(void)
+{
+	static jwb_ehandle_t cell_buf[10 * 10];
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct counter counter = {0, 0};
+	struct jwb_allocator allocator;
+	size_t i;
+	allocator.alloc = count_alloc;
+	allocator.realloc = count_realloc;
+	allocator.free = count_free;
+	allocator.ctx = &counter;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.allocator = &allocator;
+	/* Everything the world allocates goes through the allocator. */
+	assert(jwb_world_alloc(world, &alloc_info) == 0);
+	fill(world, NUM_ENTS);
+	for (i = 0; i < 10; ++i) {
+		jwb_world_step(world);
+	}
+	assert(counter.calls > 0);
+	jwb_world_destroy(world);
+	assert(counter.blocks == 0);
+	/* A given cell buffer is neither allocated nor freed. */
+	for (i = 0; i < 10 * 10; ++i) {
+		cell_buf[i] = -1;
+	}
+	alloc_info.cell_buf = cell_buf;
+	assert(jwb_world_alloc(world, &alloc_info) == 0);
+	fill(world, NUM_ENTS);
+	jwb_world_step(world);
+	jwb_world_destroy(world);
+	assert(counter.blocks == 0);
+	free(world);
+	return 0;
+}
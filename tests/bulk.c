@@ -0,0 +1,102 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 1000
+
+static struct jwb_vect pos[NUM_ENTS], vel[NUM_ENTS];
+static jwb_num_t mass[NUM_ENTS], radius[NUM_ENTS];
+static jwb_ehandle_t handles[NUM_ENTS];
+
+static size_t count_removed(jwb_world_t *world)
+{
+	size_t n = 0;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first_removed(world);
+	     e >= 0;
+	     e = jwb_world_next_removed(world, e)) {
+		++n;
+	}
+	return n;
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	size_t i, n_living;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.flags = JWBF_REMOVE_DISTANT;
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		/* About a tenth of these are off the grid. */
+		pos[i].x = frand() * 110., pos[i].y = frand() * 100.;
+		vel[i].x = frand(), vel[i].y = frand();
+		mass[i] = 1. + frand();
+		radius[i] = 1. + frand();
+	}
+	assert(jwb_world_add_ents(world, NUM_ENTS / 2, pos, vel, mass, radius,
+		handles) == 0);
+	/* Reuse destroyed handles for some of the rest. */
+	assert(jwb_world_destroy_ents(world, NUM_ENTS / 4, handles) == 0);
+	assert(jwb_world_destroy_ents(world, 1, handles) ==
+		-JWBE_DESTROYED_ENTITY);
+	assert(jwb_world_add_ents(world, NUM_ENTS / 2 + NUM_ENTS / 4,
+		pos + NUM_ENTS / 4, vel + NUM_ENTS / 4, mass + NUM_ENTS / 4,
+		radius + NUM_ENTS / 4, handles) == 0);
+	assert(jwb_world_handle_count(world) == NUM_ENTS);
+	for (i = 0; i < NUM_ENTS - NUM_ENTS / 4; ++i) {
+		struct jwb_vect p, v;
+		size_t j = i + NUM_ENTS / 4;
+		int status = jwb_world_confirm_ent(world, handles[i]);
+		assert(status == 0 || status == -JWBE_REMOVED_ENTITY);
+		assert((status == 0) == (pos[j].x < 100.));
+		jwb_world_get_pos(world, handles[i], &p);
+		jwb_world_get_vel(world, handles[i], &v);
+		assert(fequal(p.x, pos[j].x) && fequal(p.y, pos[j].y));
+		assert(fequal(v.x, vel[j].x) && fequal(v.y, vel[j].y));
+		assert(fequal(jwb_world_get_mass(world, handles[i]), mass[j]));
+		assert(fequal(jwb_world_get_radius(world, handles[i]),
+			radius[j]));
+	}
+	assert(jwb_world_living_count(world) + count_removed(world)
+		== NUM_ENTS);
+	n_living = 0;
+	for (i = 0; i < NUM_ENTS - NUM_ENTS / 4; ++i) {
+		n_living += jwb_world_confirm_ent(world, handles[i]) == 0;
+	}
+	n_living = jwb_world_living_count(world) - n_living;
+	jwb_world_remove_ents(world, NUM_ENTS - NUM_ENTS / 4, handles);
+	assert(jwb_world_living_count(world) == n_living);
+	assert(count_removed(world) == NUM_ENTS - n_living);
+	jwb_world_destroy(world);
+
+	/* Entities added to an empty world are kept in cell order. */
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		/* Stay clear of the cell edges. */
+		pos[i].x = (rand() % 10) * 10. + 1. + frand() * 8.;
+		pos[i].y = (rand() % 10) * 10. + 1. + frand() * 8.;
+	}
+	assert(jwb_world_add_ents(world, NUM_ENTS, pos, vel, mass, radius,
+		NULL) == 0);
+	assert(jwb_world_living_count(world) == NUM_ENTS);
+	n_living = 0;
+	for (i = 0; i < NUM_ENTS; ++i) {
+		const jwb_ehandle_t *living;
+		struct jwb_vect p;
+		size_t cell;
+		assert(jwb_world_living(world, i, &living) > 0);
+		jwb_world_get_pos(world, living[0], &p);
+		cell = (size_t)(p.y / 10.) * 10 + (size_t)(p.x / 10.);
+		assert(cell >= n_living);
+		n_living = cell;
+	}
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 200
+
+static struct jwb_vect positions[NUM_ENTS];
+static int states[NUM_ENTS]; /* 0: living, 1: removed, 2: destroyed */
+
+static size_t count_living(jwb_world_t *world)
+{
+	size_t n = 0;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		++n;
+	}
+	return n;
+}
+
+static size_t count_removed(jwb_world_t *world)
+{
+	size_t n = 0;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first_removed(world);
+	     e >= 0;
+	     e = jwb_world_next_removed(world, e)) {
+		++n;
+	}
+	return n;
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_ehandle_t remap[NUM_ENTS];
+	size_t i, n_living = 0, n_removed = 0;
+	jwb_ehandle_t tracked = -1;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_extra = sizeof(jwb_ehandle_t);
+	jwb_world_alloc(world, &alloc_info);
+	srand(time(NULL));
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		jwb_ehandle_t e;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = vel.y = 0.;
+		e = jwb_world_add_ent(world, &pos, &vel, 1., 0.1);
+		assert(e == (jwb_ehandle_t)i);
+		*(jwb_ehandle_t *)jwb_world_get_extra(world, e) = e;
+		jwb_world_get_pos(world, e, &positions[e]);
+	}
+	for (i = 0; i < NUM_ENTS; ++i) {
+		states[i] = rand() % 3;
+		if (states[i] == 1) {
+			jwb_world_remove_ent(world, i);
+			++n_removed;
+		} else if (states[i] == 2) {
+			jwb_world_destroy_ent(world, i);
+		} else {
+			tracked = i;
+			++n_living;
+		}
+	}
+	jwb_world_track(world, tracked);
+	assert(jwb_world_handle_count(world) == NUM_ENTS);
+	jwb_world_compact(world, remap);
+	assert(jwb_world_handle_count(world) == n_living + n_removed);
+	assert(count_living(world) == n_living);
+	assert(count_removed(world) == n_removed);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos;
+		if (states[i] == 2) {
+			assert(remap[i] == -1);
+			continue;
+		}
+		assert(remap[i] >= 0);
+		assert(remap[i] < (jwb_ehandle_t)(n_living + n_removed));
+		assert(jwb_world_confirm_ent(world, remap[i])
+			== (states[i] ? -JWBE_REMOVED_ENTITY : 0));
+		assert(*(jwb_ehandle_t *)jwb_world_get_extra(world, remap[i])
+			== (jwb_ehandle_t)i);
+		jwb_world_get_pos(world, remap[i], &pos);
+		assert(pos.x == positions[i].x && pos.y == positions[i].y);
+	}
+	if (tracked >= 0) {
+		assert(jwb_world_tracking(world) == remap[tracked]);
+	}
+	for (i = 0; i < NUM_ENTS; ++i) {
+		if (states[i] == 1) {
+			assert(jwb_world_re_add_ent(world, remap[i]) == 0);
+		}
+	}
+	for (i = 0; i < 100; ++i) {
+		jwb_world_step(world);
+	}
+	assert(count_living(world) == n_living + n_removed);
+	assert(count_removed(world) == 0);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
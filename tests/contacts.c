@@ -0,0 +1,240 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 150
+
+static int n_hits, n_begun, n_ended;
+
+/* The pairs reported touching, indexed by lesser then greater handle. */
+static char touching[NUM_ENTS][NUM_ENTS];
+static int states[NUM_ENTS]; /* 0: living, 1: removed, 2: destroyed */
+
+static void count_hit(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2,
+	struct jwb_hit_info *info)
+{
+	(void)world, (void)e1, (void)e2, (void)info;
+	++n_hits;
+}
+
+static void count_begin(jwb_world_t *world, jwb_ehandle_t e1, jwb_ehandle_t e2)
+{
+	(void)world;
+	assert(e1 < e2);
+	assert(n_begun == n_ended);
+	++n_begun;
+}
+
+static void count_end(jwb_world_t *world, jwb_ehandle_t e1, jwb_ehandle_t e2)
+{
+	(void)world;
+	assert(e1 < e2);
+	++n_ended;
+	assert(n_begun == n_ended);
+}
+
+static void add_touching(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2)
+{
+	(void)world;
+	assert(e1 < e2 && e2 < NUM_ENTS);
+	assert(!touching[e1][e2]);
+	touching[e1][e2] = 1;
+	++n_begun;
+}
+
+static void remove_touching(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2)
+{
+	(void)world;
+	assert(e1 < e2 && e2 < NUM_ENTS);
+	assert(touching[e1][e2]);
+	touching[e1][e2] = 0;
+	++n_ended;
+}
+
+/* Check the reported contacts against every pair of living entities. Returns
+ * the number of pairs touching. */
+static int check_touching(jwb_world_t *world)
+{
+	jwb_ehandle_t e1, e2;
+	int n = 0;
+	for (e1 = 0; e1 < NUM_ENTS; ++e1) {
+		for (e2 = e1 + 1; e2 < NUM_ENTS; ++e2) {
+			struct jwb_vect p1, p2, rel;
+			int touch = 0;
+			if (states[e1] == 0 && states[e2] == 0) {
+				jwb_world_get_pos(world, e1, &p1);
+				jwb_world_get_pos(world, e2, &p2);
+				rel.x = p2.x - p1.x;
+				rel.y = p2.y - p1.y;
+				touch = jwb_vect_magnitude(&rel)
+					< jwb_world_get_radius(world, e1)
+					+ jwb_world_get_radius(world, e2);
+			}
+			assert(touching[e1][e2] == touch);
+			n += touch;
+		}
+	}
+	return n;
+}
+
+/* Move a random part of the living entities somewhere else and step until
+ * they are checked against their new neighbors. They do not move otherwise.
+ * Returns the number of pairs then touching. */
+static int scatter(jwb_world_t *world)
+{
+	jwb_ehandle_t e;
+	for (e = 0; e < NUM_ENTS; ++e) {
+		if (states[e] == 0 && rand() % 3 == 0) {
+			struct jwb_vect pos;
+			pos.x = 5. + frand() * 70.;
+			pos.y = 5. + frand() * 70.;
+			jwb_world_set_pos(world, e, &pos);
+		}
+	}
+	/* Moved entities only change cells at the end of the step. */
+	jwb_world_step(world);
+	jwb_world_step(world);
+	return check_touching(world);
+}
+
+static void run_many(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	static char remapped[NUM_ENTS][NUM_ENTS];
+	jwb_ehandle_t remap[NUM_ENTS];
+	int old_states[NUM_ENTS];
+	jwb_ehandle_t e, e1, e2;
+	int i, most = 0;
+	alloc_info.cell_size = 10.;
+	alloc_info.flags = JWBF_WALLED;
+	alloc_info.width = 8;
+	alloc_info.height = 8;
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_on_hit(world, count_hit);
+	jwb_world_on_contact(world, add_touching, remove_touching);
+	memset(touching, 0, sizeof(touching));
+	n_begun = n_ended = 0;
+	for (e = 0; e < NUM_ENTS; ++e) {
+		struct jwb_vect pos, vel;
+		pos.x = 5. + frand() * 70.;
+		pos.y = 5. + frand() * 70.;
+		vel.x = vel.y = 0.;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., 1. + frand() * 3.)
+			== e);
+		states[e] = 0;
+	}
+	jwb_world_step(world);
+	check_touching(world);
+	for (i = 0; i < 10; ++i) {
+		int n = scatter(world);
+		if (n > most) {
+			most = n;
+		}
+	}
+	/* Enough pairs touched for the table to grow, and many contacts ended
+	 * next to others in the same clusters. */
+	assert(most > 100);
+	assert(n_ended > 100);
+	/* Removed entities stop touching in the next step. Contacts with
+	 * destroyed ones are forgotten when compacting. */
+	for (e = 0; e < NUM_ENTS; ++e) {
+		states[e] = rand() % 4 == 0 ? 1 + rand() % 2 : 0;
+		if (states[e] == 1) {
+			jwb_world_remove_ent(world, e);
+		} else if (states[e] == 2) {
+			jwb_world_destroy_ent(world, e);
+		}
+	}
+	jwb_world_compact(world, remap);
+	memset(remapped, 0, sizeof(remapped));
+	for (e1 = 0; e1 < NUM_ENTS; ++e1) {
+		for (e2 = e1 + 1; e2 < NUM_ENTS; ++e2) {
+			jwb_ehandle_t n1 = remap[e1], n2 = remap[e2];
+			if (!touching[e1][e2] || n1 < 0 || n2 < 0) {
+				continue;
+			}
+			if (n1 > n2) {
+				remapped[n2][n1] = 1;
+			} else {
+				remapped[n1][n2] = 1;
+			}
+		}
+	}
+	memcpy(touching, remapped, sizeof(touching));
+	memcpy(old_states, states, sizeof(states));
+	for (e = 0; e < NUM_ENTS; ++e) {
+		states[e] = 2;
+	}
+	for (e = 0; e < NUM_ENTS; ++e) {
+		if (remap[e] >= 0) {
+			states[remap[e]] = old_states[e];
+		}
+	}
+	/* The contacts carried over must end under their new handles. */
+	jwb_world_step(world);
+	check_touching(world);
+	for (i = 0; i < 10; ++i) {
+		scatter(world);
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+static void run(jwb_hit_handler_t on_hit, int steps)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect pos, vel;
+	int i;
+	alloc_info.cell_size = 10.;
+	alloc_info.flags = JWBF_WALLED;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_buf_size = 2;
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_on_hit(world, on_hit);
+	jwb_world_on_contact(world, count_begin, count_end);
+	pos.x = 30.;
+	pos.y = 50.;
+	vel.x = 1.;
+	vel.y = 0.;
+	jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	pos.x = 70.;
+	vel.x = -1.;
+	jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	n_hits = n_begun = n_ended = 0;
+	for (i = 0; i < steps; ++i) {
+		jwb_world_step(world);
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	/* The circles pass through each other, touching for several steps. */
+	run(count_hit, 60);
+	assert(n_hits > 5);
+	assert(n_begun == 1);
+	assert(n_ended == 1);
+	/* The circles bounce off each other and the walls a few times. */
+	run(jwb_elastic_collision, 200);
+	assert(n_begun > 1);
+	assert(n_begun == n_ended);
+	/* Many circles are moved around, touching and parting. */
+	srand(time(NULL));
+	run_many();
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 500
+
+/* A renderer's instance layout, with a field the world does not touch. */
+struct instance {
+	jwb_num_t x, y;
+	jwb_num_t radius;
+	int color;
+};
+
+static struct instance instances[NUM_ENTS];
+static jwb_num_t packed[NUM_ENTS * 6];
+static jwb_ehandle_t handles[NUM_ENTS];
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	size_t i, n;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100.;
+		pos.y = frand() * 100.;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1. + frand(), frand() * 5.);
+	}
+	for (i = 0; i < NUM_ENTS; i += 7) {
+		jwb_world_remove_ent(world, i);
+	}
+	jwb_world_step(world);
+	assert(jwb_world_export(world, 0, NULL, 0, NULL)
+		== jwb_world_living_count(world));
+
+	/* Strided records with a gap between fields. */
+	for (i = 0; i < NUM_ENTS; ++i) {
+		instances[i].color = (int)i;
+	}
+	n = jwb_world_export(world, JWBX_POS, instances, sizeof(*instances),
+		handles);
+	jwb_world_export(world, JWBX_RADIUS, &instances[0].radius,
+		sizeof(*instances), NULL);
+	assert(n == jwb_world_living_count(world));
+	for (i = 0; i < n; ++i) {
+		struct jwb_vect pos;
+		jwb_world_get_pos(world, handles[i], &pos);
+		assert(instances[i].x == pos.x);
+		assert(instances[i].y == pos.y);
+		assert(instances[i].radius
+			== jwb_world_get_radius(world, handles[i]));
+		assert(instances[i].color == (int)i);
+		assert(handles[i] % 7 != 0);
+	}
+
+	/* Packed records of every field for a handle list. */
+	jwb_world_export_list(world, JWBX_POS | JWBX_VEL | JWBX_RADIUS
+		| JWBX_MASS, handles, n / 2, packed, 0);
+	for (i = 0; i < n / 2; ++i) {
+		struct jwb_vect vel;
+		jwb_world_get_vel(world, handles[i], &vel);
+		assert(packed[i * 6 + 0] == instances[i].x);
+		assert(packed[i * 6 + 2] == vel.x);
+		assert(packed[i * 6 + 3] == vel.y);
+		assert(packed[i * 6 + 4] == instances[i].radius);
+		assert(packed[i * 6 + 5]
+			== jwb_world_get_mass(world, handles[i]));
+	}
+
+	/* Velocities go back in the exported order. */
+	for (i = 0; i < n * 2; ++i) {
+		packed[i] = frand();
+	}
+	assert(jwb_world_import(world, JWBX_VEL, packed, 0, NULL, n) == 0);
+	for (i = 0; i < n; ++i) {
+		struct jwb_vect vel;
+		jwb_world_get_vel(world, handles[i], &vel);
+		assert(vel.x == packed[i * 2]);
+		assert(vel.y == packed[i * 2 + 1]);
+	}
+	/* Positions go to listed entities. */
+	for (i = 0; i < 10; ++i) {
+		instances[i].x = 50.;
+		instances[i].y = 25.;
+	}
+	assert(jwb_world_import(world, JWBX_POS, instances, sizeof(*instances),
+		handles + 5, 5) == 0);
+	for (i = 0; i < n; ++i) {
+		struct jwb_vect pos;
+		jwb_world_get_pos(world, handles[i], &pos);
+		assert((i >= 5 && i < 10) == (pos.x == 50. && pos.y == 25.));
+	}
+	jwb_world_step(world);
+
+	assert(jwb_world_import(world, JWBX_RADIUS, packed, 0, NULL, n)
+		== -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_import(world, JWBX_VEL, packed, 0, NULL, n - 1)
+		== -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_import(world, JWBX_VEL, NULL, 0, handles, 1)
+		== -JWBE_INVALID_ARGUMENT);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
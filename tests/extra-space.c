@@ -39,13 +39,14 @@ static int scramble_extras(jwb_world_t *world)
 	return 0;
 }
 
-static void sim_world(size_t extra_space, struct world_outcome *outcome)
+static void sim_world(int flags, size_t extra_space,
+	struct world_outcome *outcome)
 {
 	size_t i;
 	jwb_world_t *world = malloc(sizeof(*world));
 	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
 	alloc_info.cell_size = 10.;
-	alloc_info.flags = 0;
+	alloc_info.flags = flags;
 	alloc_info.width = 10;
 	alloc_info.height = 10;
 	alloc_info.ent_buf_size = 10;
@@ -82,12 +83,15 @@ static void equal_outcome(struct world_outcome *o1, struct world_outcome *o2)
 
 int main(void)
 {
-	static struct world_outcome no_extra, some_extra, much_extra;
+	static struct world_outcome no_extra, some_extra, much_extra,
+		separate_extra;
 	seed = time(NULL);
-	sim_world(0, &no_extra);
-	sim_world(4, &some_extra);
-	sim_world(40, &much_extra);
+	sim_world(0, 0, &no_extra);
+	sim_world(0, 4, &some_extra);
+	sim_world(0, 40, &much_extra);
+	sim_world(JWBF_SEPARATE_EXTRA, 40, &separate_extra);
 	equal_outcome(&no_extra, &some_extra);
 	equal_outcome(&no_extra, &much_extra);
+	equal_outcome(&no_extra, &separate_extra);
 	return 0;
 }
@@ -0,0 +1,114 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 600
+#define DEBRIS 2U
+#define SHIP 4U
+
+static size_t n_hits;
+
+static void check_hit(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2,
+	struct jwb_hit_info *info)
+{
+	unsigned cat1, mask1, cat2, mask2;
+	jwb_world_get_filter(world, e1, &cat1, &mask1);
+	jwb_world_get_filter(world, e2, &cat2, &mask2);
+	assert((cat1 & mask2) && (cat2 & mask1));
+	++n_hits;
+	jwb_elastic_collision(world, e1, e2, info);
+}
+
+/* Simulate a crowd of debris and ships, which hit everything but debris. */
+static void simulate(int flags, unsigned seed, struct jwb_vect *positions)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	size_t i;
+	alloc_info.cell_size = 4.;
+	alloc_info.width = 25;
+	alloc_info.height = 25;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_on_hit(world, check_hit);
+	srand(seed);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		jwb_ehandle_t e;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		e = jwb_world_add_ent(world, &pos, &vel, 1., 1. + frand());
+		if (i % 4 != 0) {
+			jwb_world_set_filter(world, e, DEBRIS, ~DEBRIS);
+		} else {
+			jwb_world_set_filter(world, e, SHIP, ~0U);
+		}
+	}
+	for (i = 0; i < 100; ++i) {
+		jwb_world_step(world);
+	}
+	for (i = 0; i < NUM_ENTS; ++i) {
+		jwb_world_get_pos(world, i, &positions[i]);
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	static struct jwb_vect plain[NUM_ENTS], filtered[NUM_ENTS];
+	struct jwb_vect pos, vel;
+	jwb_ehandle_t e1, e2;
+	unsigned cat, mask, seed = time(NULL);
+	size_t i, hits_plain;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	pos.x = 20., pos.y = 50.;
+	vel.x = 1., vel.y = 0.;
+	e1 = jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	pos.x = 29.;
+	vel.x = -1.;
+	e2 = jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	jwb_world_get_filter(world, e1, &cat, &mask);
+	assert(cat == 1 && mask == ~0U);
+	/* Debris passes through debris. */
+	jwb_world_set_filter(world, e1, DEBRIS, ~DEBRIS);
+	jwb_world_set_filter(world, e2, DEBRIS, ~DEBRIS);
+	jwb_world_step(world);
+	jwb_world_get_vel(world, e1, &vel);
+	assert(fequal(vel.x, 1.));
+	/* Only one side needs to refuse the hit. */
+	jwb_world_set_filter(world, e1, DEBRIS, ~0U);
+	jwb_world_set_filter(world, e2, SHIP, ~DEBRIS);
+	jwb_world_step(world);
+	jwb_world_get_vel(world, e1, &vel);
+	assert(fequal(vel.x, 1.));
+	jwb_world_set_filter(world, e2, SHIP, ~0U);
+	jwb_world_step(world);
+	jwb_world_get_vel(world, e1, &vel);
+	assert(fequal(vel.x, -1.));
+	jwb_world_destroy_ent(world, e2);
+	assert(jwb_world_set_filter(world, e2, 1, 1) == -JWBE_DESTROYED_ENTITY);
+	jwb_world_destroy(world);
+	free(world);
+
+	/* Skipping whole cells gives the same results. */
+	n_hits = 0;
+	simulate(0, seed, plain);
+	hits_plain = n_hits;
+	n_hits = 0;
+	simulate(JWBF_CELL_FILTERS, seed, filtered);
+	assert(n_hits == hits_plain && n_hits > 0);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		assert(plain[i].x == filtered[i].x && plain[i].y == filtered[i].y);
+	}
+	return 0;
+}
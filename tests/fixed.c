@@ -0,0 +1,111 @@
+#include <jwb.h>
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+/* This test only uses JWB_NUM and JWB_NUM_TO_DOUBLE to handle numbers, so it
+ * works with any numeric type, including fixed-point numbers. */
+
+#define NUM_ENTS 40
+
+static int near(jwb_num_t num, double expected, double tolerance)
+{
+	return fabs(JWB_NUM_TO_DOUBLE(num) - expected) < tolerance;
+}
+
+static void get_momentum(jwb_world_t *world, double *x, double *y)
+{
+	jwb_ehandle_t e;
+	*x = *y = 0.;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect vel;
+		double mass = JWB_NUM_TO_DOUBLE(jwb_world_get_mass(world, e));
+		jwb_world_get_vel(world, e, &vel);
+		*x += mass * JWB_NUM_TO_DOUBLE(vel.x);
+		*y += mass * JWB_NUM_TO_DOUBLE(vel.y);
+	}
+}
+
+static void fill(jwb_world_t *world, unsigned seed)
+{
+	size_t i;
+	srand(seed);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		double mass, radius;
+		/* JWB_NUM may evaluate its argument more than once. */
+		pos.x = rand() % 1000, pos.y = rand() % 1000;
+		pos.x = JWB_NUM(pos.x / 10.), pos.y = JWB_NUM(pos.y / 10.);
+		vel.x = rand() % 200, vel.y = rand() % 200;
+		vel.x = JWB_NUM(vel.x / 100. - 1.), vel.y = JWB_NUM(vel.y / 100. - 1.);
+		mass = 1 + rand() % 4;
+		radius = 2 + rand() % 3;
+		jwb_world_add_ent(world, &pos, &vel, JWB_NUM(mass), JWB_NUM(radius));
+	}
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world)), *copy = malloc(sizeof(*copy));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect vect, pos, vel;
+	jwb_rotation_t rot;
+	jwb_ehandle_t e1, e2;
+	double px_i, py_i, px_f, py_f;
+	size_t i;
+	vect.x = JWB_NUM(3.);
+	vect.y = JWB_NUM(-4.);
+	assert(near(jwb_vect_magnitude(&vect), 5., .001));
+	jwb_vect_normalize(&vect);
+	assert(near(vect.x, .6, .001) && near(vect.y, -.8, .001));
+	/* Vectors with no length are left alone rather than divided by zero. */
+	vect.x = vect.y = 0;
+	jwb_vect_normalize(&vect);
+	assert(vect.x == 0 && vect.y == 0);
+	jwb_vect_rotation(&vect, &rot);
+	assert(near(rot.cos, 1., .001) && near(rot.sin, 0., .001));
+
+	alloc_info.cell_size = JWB_NUM(10.);
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	/* Equal masses colliding head-on swap velocities. */
+	pos.x = JWB_NUM(20.), pos.y = JWB_NUM(50.);
+	vel.x = JWB_NUM(1.), vel.y = 0;
+	e1 = jwb_world_add_ent(world, &pos, &vel, JWB_NUM(1.), JWB_NUM(5.));
+	pos.x = JWB_NUM(40.5);
+	vel.x = JWB_NUM(-1.);
+	e2 = jwb_world_add_ent(world, &pos, &vel, JWB_NUM(1.), JWB_NUM(5.));
+	for (i = 0; i < 10; ++i) {
+		jwb_world_step(world);
+	}
+	jwb_world_get_vel(world, e1, &vel);
+	assert(near(vel.x, -1., .001) && near(vel.y, 0., .001));
+	jwb_world_get_vel(world, e2, &vel);
+	assert(near(vel.x, 1., .001) && near(vel.y, 0., .001));
+	jwb_world_destroy(world);
+
+	/* Momentum is conserved in a crowd, and the results are repeatable. */
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_alloc(copy, &alloc_info);
+	fill(world, 1234);
+	fill(copy, 1234);
+	get_momentum(world, &px_i, &py_i);
+	for (i = 0; i < 200; ++i) {
+		jwb_world_step(world);
+		jwb_world_step(copy);
+	}
+	get_momentum(world, &px_f, &py_f);
+	assert(fabs(px_f - px_i) < .1 && fabs(py_f - py_i) < .1);
+	for (e1 = 0; e1 < NUM_ENTS; ++e1) {
+		struct jwb_vect pos2;
+		jwb_world_get_pos(world, e1, &pos);
+		jwb_world_get_pos(copy, e1, &pos2);
+		assert(pos.x == pos2.x && pos.y == pos2.y);
+	}
+	jwb_world_destroy(world);
+	jwb_world_destroy(copy);
+	free(world);
+	free(copy);
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 10
+
+static jwb_world_t *make_world(int seed)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	size_t i;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_buf_size = NUM_ENTS;
+	jwb_world_alloc(world, &alloc_info);
+	srand(seed);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() * 4., vel.y = frand() * 4.;
+		jwb_world_add_ent(world, &pos, &vel, frand() + 0.5, frand());
+	}
+	return world;
+}
+
+static void free_world(jwb_world_t *world)
+{
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	jwb_world_t *world1, *world2;
+	struct jwb_vect pos, vel, gravity;
+	jwb_ehandle_t e1, e2;
+	size_t i;
+	int seed = time(NULL);
+	/* Built-in friction is the same as a separate friction pass. */
+	world1 = make_world(seed);
+	world2 = make_world(seed);
+	assert(jwb_world_set_friction(world1, 0.01) == 0);
+	assert(jwb_world_set_friction(world1, -1.) == -JWBE_INVALID_ARGUMENT);
+	for (i = 0; i < 200; ++i) {
+		jwb_world_step(world1);
+		jwb_world_step(world2);
+		jwb_world_apply_friction(world2, 0.01);
+	}
+	for (e1 = jwb_world_first(world1), e2 = jwb_world_first(world2);
+	     e1 >= 0 && e2 >= 0;
+	     e1 = jwb_world_next(world1, e1), e2 = jwb_world_next(world2, e2))
+	{
+		struct jwb_vect vel1, vel2;
+		jwb_world_get_vel(world1, e1, &vel1);
+		jwb_world_get_vel(world2, e2, &vel2);
+		assert(vel1.x == vel2.x && vel1.y == vel2.y);
+	}
+	free_world(world1);
+	free_world(world2);
+	/* Gravity and damping. */
+	world1 = make_world(seed);
+	while ((e1 = jwb_world_first(world1)) >= 0) {
+		jwb_world_destroy_ent(world1, e1);
+	}
+	pos.x = pos.y = 50.;
+	vel.x = vel.y = 0.;
+	e1 = jwb_world_add_ent(world1, &pos, &vel, 1., 1.);
+	gravity.x = 0.;
+	gravity.y = -0.5;
+	jwb_world_set_gravity(world1, &gravity);
+	for (i = 0; i < 4; ++i) {
+		jwb_world_step(world1);
+	}
+	jwb_world_get_vel(world1, e1, &vel);
+	jwb_world_get_pos(world1, e1, &pos);
+	assert(fequal(vel.y, -2.));
+	assert(fequal(pos.y, 47.));
+	gravity.y = 0.;
+	jwb_world_set_gravity(world1, &gravity);
+	jwb_world_set_damping(world1, 0.25);
+	jwb_world_step_dt(world1, 2., 1);
+	jwb_world_get_vel(world1, e1, &vel);
+	assert(fequal(vel.y, -1.));
+	free_world(world1);
+	return 0;
+}
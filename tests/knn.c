@@ -0,0 +1,118 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 1500
+#define NUM_POINTS 100
+#define MAX_K 40
+#define CELL_SIZE 5.
+#define WIDTH 20
+#define HEIGHT 15
+
+static double dists[NUM_ENTS];
+static struct jwb_neighbor found[NUM_POINTS * MAX_K];
+static size_t counts[NUM_POINTS];
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+/* Get the distance along one axis, the shortest way around if `wrap` is set. */
+static double axis_dist(double a, double b, double lim, int wrap)
+{
+	double d = fabs(a - b);
+	if (wrap) {
+		d = fmod(d, lim);
+		if (d > lim / 2) {
+			d = lim - d;
+		}
+	}
+	return d;
+}
+
+/* Check one search against the brute force distances. */
+static void check_found(jwb_world_t *world, const struct jwb_vect *point,
+	const struct jwb_neighbor *nbrs, size_t n, size_t k, int wrap)
+{
+	double lim_x = WIDTH * CELL_SIZE, lim_y = HEIGHT * CELL_SIZE;
+	size_t i, n_ents = 0;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect pos;
+		double dx, dy;
+		jwb_world_get_pos(world, e, &pos);
+		dx = axis_dist(pos.x, point->x, lim_x, wrap);
+		dy = axis_dist(pos.y, point->y, lim_y, wrap);
+		dists[n_ents++] = sqrt(dx * dx + dy * dy);
+	}
+	qsort(dists, n_ents, sizeof(*dists), compare_doubles);
+	assert(n == (k < n_ents ? k : n_ents));
+	for (i = 0; i < n; ++i) {
+		struct jwb_vect pos;
+		double dx, dy;
+		assert(fequal(nbrs[i].dist, dists[i]));
+		jwb_world_get_pos(world, nbrs[i].ent, &pos);
+		dx = axis_dist(pos.x, point->x, lim_x, wrap);
+		dy = axis_dist(pos.y, point->y, lim_y, wrap);
+		assert(fequal(nbrs[i].dist, sqrt(dx * dx + dy * dy)));
+	}
+}
+
+static void test_knn(int flags, size_t n_ents)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect off, points[NUM_POINTS];
+	double lim_x = WIDTH * CELL_SIZE, lim_y = HEIGHT * CELL_SIZE;
+	int wrap = !flags;
+	size_t i, k;
+	alloc_info.cell_size = CELL_SIZE;
+	alloc_info.width = WIDTH;
+	alloc_info.height = HEIGHT;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	off.x = -8.;
+	off.y = 33.;
+	jwb_world_offset(world, &off);
+	for (i = 0; i < n_ents; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = off.x + frand() * lim_x;
+		pos.y = off.y + frand() * lim_y;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1., frand() * CELL_SIZE);
+	}
+	jwb_world_step(world);
+	for (i = 0; i < NUM_POINTS; ++i) {
+		points[i].x = off.x + (frand() * 1.6 - .3) * lim_x;
+		points[i].y = off.y + (frand() * 1.6 - .3) * lim_y;
+	}
+	for (k = 1; k <= MAX_K; k += 13) {
+		for (i = 0; i < NUM_POINTS; ++i) {
+			size_t n = jwb_world_knn(world, &points[i], k, found);
+			check_found(world, &points[i], found, n, k, wrap);
+		}
+		jwb_world_knn_batch(world, NUM_POINTS, points, k, found, counts);
+		for (i = 0; i < NUM_POINTS; ++i) {
+			check_found(world, &points[i], found + i * k, counts[i], k,
+				wrap);
+		}
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	test_knn(0, NUM_ENTS);
+	test_knn(JWBF_WALLED, NUM_ENTS);
+	test_knn(JWBF_REMOVE_DISTANT, NUM_ENTS);
+	/* Sparse worlds, with fewer entities than are asked for. */
+	test_knn(0, 20);
+	test_knn(JWBF_REMOVE_DISTANT, 20);
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 3000
+
+static char seen[NUM_ENTS];
+static char alive[NUM_ENTS];
+
+/* Check that iteration visits exactly the living entities once each. */
+static void check_iteration(jwb_world_t *world)
+{
+	const jwb_ehandle_t *handles;
+	jwb_ehandle_t e;
+	size_t i, n, start, n_alive = 0;
+	for (i = 0; i < NUM_ENTS; ++i) {
+		n_alive += alive[i];
+	}
+	assert(jwb_world_living_count(world) == n_alive);
+	memset(seen, 0, sizeof(seen));
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		assert(alive[e] && !seen[e]);
+		seen[e] = 1;
+	}
+	assert(memcmp(seen, alive, sizeof(seen)) == 0);
+	memset(seen, 0, sizeof(seen));
+	for (start = 0; (n = jwb_world_living(world, start, &handles)) > 0;
+	     start += n) {
+		for (i = 0; i < n; ++i) {
+			assert(alive[handles[i]] && !seen[handles[i]]);
+			seen[handles[i]] = 1;
+		}
+	}
+	assert(start == n_alive);
+	assert(memcmp(seen, alive, sizeof(seen)) == 0);
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_ehandle_t e, next;
+	size_t i;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	srand(time(NULL));
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = vel.y = 0.;
+		e = jwb_world_add_ent(world, &pos, &vel, 1., 1.);
+		assert(e == (jwb_ehandle_t)i);
+		alive[e] = 1;
+	}
+	check_iteration(world);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		switch (rand() % 4) {
+		case 0:
+			jwb_world_remove_ent(world, i);
+			alive[i] = 0;
+			break;
+		case 1:
+			jwb_world_destroy_ent(world, i);
+			alive[i] = 0;
+			break;
+		}
+	}
+	check_iteration(world);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		if (jwb_world_re_add_ent(world, i) == 0) {
+			alive[i] = 1;
+		}
+	}
+	check_iteration(world);
+	/* Remove some entities while iterating over them. */
+	memset(seen, 0, sizeof(seen));
+	for (e = jwb_world_first(world); e >= 0; e = next) {
+		next = jwb_world_next(world, e);
+		assert(!seen[e]);
+		seen[e] = 1;
+		if (rand() % 2) {
+			jwb_world_remove_ent(world, e);
+			alive[e] = 0;
+			/* Asking after removal gives the same next entity. */
+			assert(jwb_world_next(world, e) == next);
+		}
+	}
+	check_iteration(world);
+	jwb_world_compact(world, NULL);
+	memset(alive, 0, sizeof(alive));
+	for (i = 0; i < jwb_world_living_count(world); ++i) {
+		alive[i] = 1;
+	}
+	check_iteration(world);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
@@ -0,0 +1,117 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 200
+
+static struct jwb_vect exact[NUM_ENTS];
+
+/* Take the nearest copy of an offset in a world of size `lim`, if it is not
+ * zero. */
+static jwb_num_t nearest(jwb_num_t rel, jwb_num_t lim)
+{
+	return lim > 0. ? rel - lim * floor(rel / lim + .5) : rel;
+}
+
+/* Find the exact pulls. The world is lim_x by lim_y if it wraps, or else those
+ * are zero. */
+static void get_exact(jwb_world_t *world, jwb_num_t softening, jwb_num_t lim_x,
+	jwb_num_t lim_y)
+{
+	jwb_ehandle_t e1, e2;
+	for (e1 = jwb_world_first(world); e1 >= 0; e1 = jwb_world_next(world, e1))
+	{
+		struct jwb_vect pos1;
+		jwb_world_get_pos(world, e1, &pos1);
+		exact[e1].x = exact[e1].y = 0.;
+		for (e2 = jwb_world_first(world);
+		     e2 >= 0;
+		     e2 = jwb_world_next(world, e2))
+		{
+			struct jwb_vect pos2;
+			jwb_num_t dist2, scale;
+			if (e1 == e2) {
+				continue;
+			}
+			jwb_world_get_pos(world, e2, &pos2);
+			pos2.x = nearest(pos2.x - pos1.x, lim_x);
+			pos2.y = nearest(pos2.y - pos1.y, lim_y);
+			dist2 = pos2.x * pos2.x + pos2.y * pos2.y
+				+ softening * softening;
+			scale = jwb_world_get_mass(world, e2)
+				/ (dist2 * sqrt(dist2));
+			exact[e1].x += pos2.x * scale;
+			exact[e1].y += pos2.y * scale;
+		}
+	}
+}
+
+/* Get the relative error of the velocities (which started at zero.) */
+static jwb_num_t get_error(jwb_world_t *world)
+{
+	jwb_num_t error = 0., total = 0.;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect vel;
+		jwb_world_get_vel(world, e, &vel);
+		vel.x -= exact[e].x;
+		vel.y -= exact[e].y;
+		error += jwb_vect_magnitude(&vel);
+		total += jwb_vect_magnitude(&exact[e]);
+		vel.x = vel.y = 0.;
+		jwb_world_set_vel(world, e, &vel);
+	}
+	return error / total;
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_long_range params;
+	struct jwb_vect pos, vel;
+	size_t i;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 8;
+	alloc_info.ent_buf_size = NUM_ENTS;
+	jwb_world_alloc(world, &alloc_info);
+	srand(time(NULL));
+	for (i = 0; i < NUM_ENTS; ++i) {
+		pos.x = frand() * 100., pos.y = frand() * 80.;
+		vel.x = vel.y = 0.;
+		jwb_world_add_ent(world, &pos, &vel, frand() + 0.5, 0.1);
+	}
+	params.strength = 1.;
+	params.softening = 0.5;
+	/* The world wraps, so the pulls go the shortest way around. */
+	get_exact(world, params.softening, 100., 80.);
+	params.theta = 0.;
+	assert(jwb_world_apply_long_range(world, &params, 1.) == 0);
+	assert(get_error(world) < 0.00001);
+	params.theta = 0.5;
+	assert(jwb_world_apply_long_range(world, &params, 1.) == 0);
+	assert(get_error(world) < 0.05);
+	params.theta = -1.;
+	assert(jwb_world_apply_long_range(world, &params, 1.)
+		== -JWBE_INVALID_ARGUMENT);
+	jwb_world_destroy(world);
+
+	/* With a huge opening angle, the whole tree is taken at once. Each
+	 * entity must still be pulled only by the other. */
+	alloc_info.flags = JWBF_WALLED;
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < 2; ++i) {
+		pos.x = frand() * 80. + 10., pos.y = frand() * 60. + 10.;
+		vel.x = vel.y = 0.;
+		jwb_world_add_ent(world, &pos, &vel, frand() + 0.5, 0.1);
+	}
+	get_exact(world, params.softening, 0., 0.);
+	params.theta = 1000.;
+	assert(jwb_world_apply_long_range(world, &params, 1.) == 0);
+	assert(get_error(world) < 0.00001);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
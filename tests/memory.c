@@ -0,0 +1,111 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 2000
+
+static void touch_nothing(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2)
+{
+	(void)world, (void)e1, (void)e2;
+}
+
+static void check_ents(jwb_world_t *world, const jwb_ehandle_t *remap)
+{
+	jwb_ehandle_t e;
+	for (e = 0; e < NUM_ENTS; ++e) {
+		jwb_ehandle_t *extra;
+		if (remap[e] < 0) {
+			continue;
+		}
+		extra = jwb_world_get_extra(world, remap[e]);
+		assert(*extra == e);
+	}
+}
+
+static void run(int flags)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_ehandle_t remap[NUM_ENTS];
+	size_t before, reserved, grown, shrunk, i;
+	jwb_ehandle_t e;
+	alloc_info.flags = flags;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_extra = sizeof(jwb_ehandle_t);
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_on_contact(world, touch_nothing, NULL);
+	before = jwb_world_memory_usage(world);
+	assert(before >= sizeof(*world) + 10 * 10 * sizeof(jwb_ehandle_t));
+	assert(jwb_world_reserve(world, NUM_ENTS) == 0);
+	reserved = jwb_world_memory_usage(world);
+	assert(reserved >= before + NUM_ENTS * (sizeof(jwb_ehandle_t)
+		+ jwb_world_extra_size(world)));
+	/* Adding up to the reserved amount does not grow the entities. */
+	for (e = 0; e < NUM_ENTS; ++e) {
+		struct jwb_vect pos, vel;
+		jwb_ehandle_t *extra;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., 2.) == e);
+		extra = jwb_world_get_extra(world, e);
+		*extra = e;
+		remap[e] = e;
+	}
+	for (i = 0; i < 5; ++i) {
+		jwb_world_step(world);
+	}
+	grown = jwb_world_memory_usage(world);
+	assert(grown > reserved);
+	/* Despawn most entities and give back the space. */
+	for (e = 0; e < NUM_ENTS; ++e) {
+		if (e % 10 != 0) {
+			jwb_world_destroy_ent(world, e);
+		} else if (e % 20 == 0) {
+			jwb_world_remove_ent(world, e);
+		}
+	}
+	jwb_world_compact(world, remap);
+	check_ents(world, remap);
+	assert(jwb_world_regrid(world, 20., 5, 5) == 0);
+	jwb_world_shrink_to_fit(world);
+	shrunk = jwb_world_memory_usage(world);
+	assert(shrunk < grown * 3 / 4);
+#ifndef JWBO_PAGED_ENTS
+	assert(shrunk < before + NUM_ENTS / 5 * (sizeof(jwb_ehandle_t)
+		+ jwb_world_extra_size(world) + 128));
+#endif
+	check_ents(world, remap);
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		assert(jwb_world_confirm_ent(world, e) == 0);
+	}
+	assert(jwb_world_living_count(world) == NUM_ENTS / 20);
+	for (i = 0; i < 5; ++i) {
+		jwb_world_step(world);
+	}
+	/* The world can still grow afterwards. */
+	for (e = 0; e < NUM_ENTS; ++e) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = vel.y = 0.;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., 2.) >= 0);
+	}
+	check_ents(world, remap);
+	jwb_world_shrink_to_fit(world);
+	check_ents(world, remap);
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	run(0);
+	run(JWBF_SEPARATE_EXTRA);
+	return 0;
+}
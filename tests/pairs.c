@@ -0,0 +1,113 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 400
+#define CELL_SIZE 5.
+#define MAX_PAIRS (NUM_ENTS * NUM_ENTS / 2)
+
+static struct jwb_pair pairs[MAX_PAIRS];
+static char expected[NUM_ENTS][NUM_ENTS];
+
+/* Get the offset along one axis, the shortest way around if `wrap` is set. */
+static double axis_delta(double from, double to, double lim, int wrap)
+{
+	double d = to - from;
+	if (wrap) {
+		d = fmod(d, lim);
+		if (d > lim / 2) {
+			d -= lim;
+		} else if (d < -lim / 2) {
+			d += lim;
+		}
+	}
+	return d;
+}
+
+static void test_pairs(int flags, size_t width, size_t height, double margin,
+	double max_radius)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect off;
+	double lim_x = width * CELL_SIZE, lim_y = height * CELL_SIZE;
+	int wrap = !flags;
+	size_t i, n, n_expected = 0;
+	jwb_ehandle_t e1, e2;
+	alloc_info.cell_size = CELL_SIZE;
+	alloc_info.width = width;
+	alloc_info.height = height;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	off.x = 3.;
+	off.y = -7.;
+	jwb_world_offset(world, &off);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = off.x + frand() * lim_x;
+		pos.y = off.y + frand() * lim_y;
+		vel.x = vel.y = 0.;
+		jwb_world_add_ent(world, &pos, &vel, 1., frand() * max_radius);
+	}
+	memset(expected, 0, sizeof(expected));
+	for (e1 = jwb_world_first(world); e1 >= 0;
+	     e1 = jwb_world_next(world, e1)) {
+		for (e2 = jwb_world_first(world); e2 >= 0;
+		     e2 = jwb_world_next(world, e2)) {
+			struct jwb_vect p1, p2;
+			double dx, dy, reach;
+			if (e1 >= e2) {
+				continue;
+			}
+			jwb_world_get_pos(world, e1, &p1);
+			jwb_world_get_pos(world, e2, &p2);
+			dx = axis_delta(p1.x, p2.x, lim_x, wrap);
+			dy = axis_delta(p1.y, p2.y, lim_y, wrap);
+			reach = jwb_world_get_radius(world, e1)
+				+ jwb_world_get_radius(world, e2) + margin;
+			if (dx * dx + dy * dy < reach * reach) {
+				expected[e1][e2] = 1;
+				++n_expected;
+			}
+		}
+	}
+	n = jwb_world_pairs(world, margin, pairs, MAX_PAIRS);
+	assert(n == n_expected);
+	for (i = 0; i < n; ++i) {
+		struct jwb_vect p1, p2;
+		e1 = pairs[i].ent1;
+		e2 = pairs[i].ent2;
+		assert(e1 < e2);
+		/* Each pair is found once. */
+		assert(expected[e1][e2]);
+		expected[e1][e2] = 0;
+		jwb_world_get_pos(world, e1, &p1);
+		jwb_world_get_pos(world, e2, &p2);
+		assert(fequal(pairs[i].info.rel.x,
+			axis_delta(p1.x, p2.x, lim_x, wrap)));
+		assert(fequal(pairs[i].info.rel.y,
+			axis_delta(p1.y, p2.y, lim_y, wrap)));
+		assert(fequal(pairs[i].info.dist,
+			jwb_vect_magnitude(&pairs[i].info.rel)));
+	}
+	assert(jwb_world_pairs(world, margin, NULL, 0) == n);
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	test_pairs(0, 20, 15, 0., CELL_SIZE / 2);
+	test_pairs(JWBF_WALLED, 20, 15, 0., CELL_SIZE / 2);
+	test_pairs(JWBF_REMOVE_DISTANT, 20, 15, 0., CELL_SIZE / 2);
+	/* More layers of neighbors are needed. */
+	test_pairs(0, 20, 15, 3., CELL_SIZE);
+	test_pairs(JWBF_REMOVE_DISTANT, 20, 15, 7., CELL_SIZE);
+	/* Small worlds where neighbors wrap around onto each other. */
+	test_pairs(0, 2, 3, 0., CELL_SIZE / 2);
+	test_pairs(0, 4, 4, 6., CELL_SIZE);
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 2000
+#define NUM_QUERIES 200
+#define CELL_SIZE 5.
+#define WIDTH 20
+#define HEIGHT 15
+
+static jwb_ehandle_t found[NUM_ENTS];
+static char expected[NUM_ENTS];
+
+/* Get the distance from a number to a range, considering copies of the number
+ * shifted by multiples of `lim` if `wrap` is set. */
+static double gap(double pos, double min, double max, double lim, int wrap)
+{
+	double best = HUGE_VAL;
+	int k;
+	for (k = wrap ? -3 : 0; k <= (wrap ? 3 : 0); ++k) {
+		double p = pos + k * lim;
+		double g = p < min ? min - p : p > max ? p - max : 0.;
+		if (g < best) {
+			best = g;
+		}
+	}
+	return best;
+}
+
+/* Compare the query results with the brute force ones in `expected`. */
+static void check_found(size_t n)
+{
+	size_t i, n_expected = 0;
+	for (i = 0; i < NUM_ENTS; ++i) {
+		n_expected += expected[i];
+	}
+	assert(n == n_expected);
+	for (i = 0; i < n; ++i) {
+		assert(expected[found[i]]);
+		/* Each one is found only once. */
+		expected[found[i]] = 0;
+	}
+}
+
+static void test_queries(int flags)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect off;
+	double lim_x = WIDTH * CELL_SIZE, lim_y = HEIGHT * CELL_SIZE;
+	int wrap = !flags;
+	size_t i;
+	jwb_ehandle_t e;
+	alloc_info.cell_size = CELL_SIZE;
+	alloc_info.width = WIDTH;
+	alloc_info.height = HEIGHT;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	off.x = -30.;
+	off.y = 12.;
+	jwb_world_offset(world, &off);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = off.x + frand() * lim_x;
+		pos.y = off.y + frand() * lim_y;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1., frand() * CELL_SIZE);
+	}
+	jwb_world_step(world);
+	for (i = 0; i < NUM_QUERIES; ++i) {
+		struct jwb_vect min, max, center;
+		double radius;
+		size_t n;
+		min.x = off.x + (frand() * 2. - .5) * lim_x;
+		min.y = off.y + (frand() * 2. - .5) * lim_y;
+		max.x = min.x + frand() * lim_x * .7;
+		max.y = min.y + frand() * lim_y * .7;
+		memset(expected, 0, sizeof(expected));
+		for (e = jwb_world_first(world); e >= 0;
+		     e = jwb_world_next(world, e)) {
+			struct jwb_vect pos;
+			double gx, gy, r = jwb_world_get_radius(world, e);
+			jwb_world_get_pos(world, e, &pos);
+			gx = gap(pos.x, min.x, max.x, lim_x, wrap);
+			gy = gap(pos.y, min.y, max.y, lim_y, wrap);
+			expected[e] = gx * gx + gy * gy <= r * r;
+		}
+		n = jwb_world_query_aabb(world, &min, &max, found, NUM_ENTS);
+		check_found(n);
+
+		center = min;
+		radius = frand() * lim_x * .4;
+		memset(expected, 0, sizeof(expected));
+		for (e = jwb_world_first(world); e >= 0;
+		     e = jwb_world_next(world, e)) {
+			struct jwb_vect pos;
+			double gx, gy, r = jwb_world_get_radius(world, e) + radius;
+			jwb_world_get_pos(world, e, &pos);
+			gx = gap(pos.x, center.x, center.x, lim_x, wrap);
+			gy = gap(pos.y, center.y, center.y, lim_y, wrap);
+			expected[e] = gx * gx + gy * gy <= r * r;
+		}
+		n = jwb_world_query_circle(world, &center, radius, found,
+			NUM_ENTS);
+		check_found(n);
+		/* Only as many handles as fit are stored. */
+		assert(jwb_world_query_circle(world, &center, radius, NULL, 0)
+			== n);
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	test_queries(0);
+	test_queries(JWBF_WALLED);
+	test_queries(JWBF_REMOVE_DISTANT);
+	return 0;
+}
@@ -0,0 +1,200 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <float.h>
+#include <time.h>
+
+#define NUM_ENTS 1000
+#define NUM_RAYS 300
+#define CELL_SIZE 5.
+#define WIDTH 20
+#define HEIGHT 15
+
+/* A hit found by brute force. */
+struct expected_hit {
+	double dist;
+	/* How far the distance can be moved by rounding, per unit of the
+	 * precision of the numbers. */
+	double slack;
+};
+
+static struct jwb_ray_hit hits[NUM_ENTS * 4];
+static struct expected_hit expected[NUM_ENTS * 4];
+
+/* Only odd entities can be hit. */
+static int odd(jwb_world_t *world, jwb_ehandle_t ent)
+{
+	(void)world;
+	return ent % 2;
+}
+
+static int compare_hits(const void *a, const void *b)
+{
+	double x = ((const struct expected_hit *)a)->dist;
+	double y = ((const struct expected_hit *)b)->dist;
+	return x < y ? -1 : x > y;
+}
+
+/* Check a distance against the expected one, allowing for rounding. */
+static int dist_equal(double dist, const struct expected_hit *exp)
+{
+	double eps = sizeof(jwb_num_t) < sizeof(double)
+		? FLT_EPSILON : DBL_EPSILON;
+	return fabs(dist - exp->dist) < .0001 + 16. * eps * exp->slack;
+}
+
+/* Find the distance along a ray (with a unit direction) to a circle, or a
+ * negative number if the ray misses. Like the hit test, this goes by the part
+ * of the offset across the ray, since `along * along` would magnify the
+ * rounding of a single-precision direction. The positions are rounded too,
+ * which moves the hit further the closer the ray comes to only grazing. */
+static double ray_circle(const struct jwb_vect *origin,
+	const struct jwb_vect *dir, double cx, double cy, double radius,
+	double *slack)
+{
+	double rx = origin->x - cx, ry = origin->y - cy;
+	double along = rx * dir->x + ry * dir->y;
+	double outside = rx * rx + ry * ry - radius * radius;
+	double px = rx - along * dir->x, py = ry - along * dir->y;
+	double disc = radius * radius - px * px - py * py;
+	double scale = fabs(origin->x) + fabs(origin->y) + fabs(cx) + fabs(cy);
+	if (outside <= 0.) {
+		*slack = 0.;
+		return 0.;
+	}
+	if (along > 0. || disc < 0.) {
+		return -1.;
+	}
+	*slack = scale * (1. + radius / (sqrt(disc) + scale * FLT_EPSILON));
+	return -along - sqrt(disc);
+}
+
+static void test_rays(int flags)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect off;
+	double lim_x = WIDTH * CELL_SIZE, lim_y = HEIGHT * CELL_SIZE;
+	int wrap = !flags;
+	size_t i, n;
+	jwb_ehandle_t e;
+	alloc_info.cell_size = CELL_SIZE;
+	alloc_info.width = WIDTH;
+	alloc_info.height = HEIGHT;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	off.x = 17.;
+	off.y = -40.;
+	jwb_world_offset(world, &off);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = off.x + frand() * lim_x;
+		pos.y = off.y + frand() * lim_y;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1., .2 + frand() * 2.);
+	}
+	jwb_world_step(world);
+	for (i = 0; i < NUM_RAYS; ++i) {
+		struct jwb_vect origin, dir, unit;
+		struct jwb_ray_hit first;
+		double max_dist, mag;
+		size_t n_expected = 0;
+		int k, l;
+		origin.x = off.x + (frand() * 1.4 - .2) * lim_x;
+		origin.y = off.y + (frand() * 1.4 - .2) * lim_y;
+		dir.x = frand() - .5;
+		dir.y = frand() - .5;
+		if (i % 10 == 0) {
+			/* Rays along the axes. */
+			dir.y = 0.;
+		}
+		mag = sqrt(dir.x * dir.x + dir.y * dir.y);
+		unit.x = dir.x / mag;
+		unit.y = dir.y / mag;
+		max_dist = frand() * lim_x * 1.5;
+		for (e = jwb_world_first(world); e >= 0;
+		     e = jwb_world_next(world, e)) {
+			struct jwb_vect pos;
+			double r = jwb_world_get_radius(world, e);
+			if (!odd(world, e)) {
+				continue;
+			}
+			jwb_world_get_pos(world, e, &pos);
+			for (k = wrap ? -3 : 0; k <= (wrap ? 3 : 0); ++k) {
+				for (l = wrap ? -3 : 0; l <= (wrap ? 3 : 0); ++l) {
+					double slack, d = ray_circle(&origin,
+						&unit, pos.x + k * lim_x,
+						pos.y + l * lim_y, r, &slack);
+					if (d >= 0. && d <= max_dist) {
+						expected[n_expected].dist = d;
+						expected[n_expected].slack =
+							slack;
+						++n_expected;
+					}
+				}
+			}
+		}
+		qsort(expected, n_expected, sizeof(*expected), compare_hits);
+		n = jwb_world_raycast_all(world, &origin, &dir, max_dist, odd,
+			hits, NUM_ENTS * 4);
+		assert(n == n_expected);
+		for (n = 0; n < n_expected; ++n) {
+			assert(dist_equal(hits[n].dist, &expected[n]));
+			assert(odd(world, hits[n].ent));
+			if (hits[n].dist > 0.) {
+				/* The normal faces back toward the origin. */
+				assert(fequal(hits[n].normal.x * hits[n].normal.x
+					+ hits[n].normal.y * hits[n].normal.y, 1.));
+				assert(hits[n].normal.x * dir.x
+					+ hits[n].normal.y * dir.y <= 0.0001);
+			}
+		}
+		assert(jwb_world_raycast(world, &origin, &dir, max_dist, odd,
+			&first) == (n_expected > 0));
+		if (n_expected > 0) {
+			assert(dist_equal(first.dist, &expected[0]));
+		}
+		/* Only the nearest hits are stored. */
+		if (n_expected > 2) {
+			assert(jwb_world_raycast_all(world, &origin, &dir, max_dist,
+				odd, hits, 2) == n_expected);
+			assert(dist_equal(hits[0].dist, &expected[0]));
+			assert(dist_equal(hits[1].dist, &expected[1]));
+		}
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect origin, dir, pos, vel;
+	struct jwb_ray_hit hit;
+	srand(time(NULL));
+	test_rays(0);
+	test_rays(JWBF_WALLED);
+	test_rays(JWBF_REMOVE_DISTANT);
+	/* A simple ray across the edge of a wrapping world. */
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	pos.x = 5., pos.y = 50.;
+	vel.x = vel.y = 0.;
+	jwb_world_add_ent(world, &pos, &vel, 1., 2.);
+	origin.x = 90., origin.y = 50.;
+	dir.x = 1., dir.y = 0.;
+	assert(jwb_world_raycast(world, &origin, &dir, 100., NULL, &hit) == 1);
+	assert(hit.ent == 0 && fequal(hit.dist, 13.));
+	assert(fequal(hit.normal.x, -1.) && fequal(hit.normal.y, 0.));
+	assert(jwb_world_raycast(world, &origin, &dir, 12., NULL, &hit) == 0);
+	dir.x = 0.;
+	assert(jwb_world_raycast(world, &origin, &dir, 1., NULL, &hit)
+		== -JWBE_INVALID_ARGUMENT);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
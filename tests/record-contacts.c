@@ -0,0 +1,92 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 300
+#define MAX_HITS 10000
+
+static jwb_ehandle_t hits[MAX_HITS][2];
+static size_t n_hits;
+
+static void count_hit(
+	jwb_world_t *world,
+	jwb_ehandle_t e1,
+	jwb_ehandle_t e2,
+	struct jwb_hit_info *info)
+{
+	assert(n_hits < MAX_HITS);
+	hits[n_hits][0] = e1;
+	hits[n_hits][1] = e2;
+	++n_hits;
+	jwb_elastic_collision(world, e1, e2, info);
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	const struct jwb_contact *contacts;
+	struct jwb_vect pos, vel;
+	size_t i, n, step, total = 0;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	/* Head-on hit of equal masses: the velocities swap. */
+	pos.x = 20., pos.y = 50.;
+	vel.x = 1., vel.y = 0.;
+	jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	pos.x = 29.;
+	vel.x = -1.;
+	jwb_world_add_ent(world, &pos, &vel, 1., 5.);
+	jwb_world_record_contacts(world, 1);
+	jwb_world_step(world);
+	contacts = jwb_world_contacts(world, &n);
+	assert(n == 1);
+	assert(contacts[0].ent1 + contacts[0].ent2 == 1);
+	assert(fequal(contacts[0].info.dist, 9.));
+	assert(fequal(contacts[0].impulse, 2.));
+	for (i = 0; i < 10; ++i) {
+		jwb_world_step(world);
+	}
+	jwb_world_contacts(world, &n);
+	assert(n == 0);
+	jwb_world_destroy(world);
+
+	/* The list has the same hits as the hit handler sees. */
+	jwb_world_alloc(world, &alloc_info);
+	jwb_world_on_hit(world, count_hit);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1. + frand(), 1. + frand());
+	}
+	jwb_world_record_contacts(world, 1);
+	for (step = 0; step < 50; ++step) {
+		n_hits = 0;
+		if (step % 2) {
+			jwb_world_step(world);
+		} else {
+			jwb_world_step_dt(world, 1., 3);
+		}
+		contacts = jwb_world_contacts(world, &n);
+		assert(n == n_hits);
+		for (i = 0; i < n; ++i) {
+			assert(contacts[i].ent1 == hits[i][0]);
+			assert(contacts[i].ent2 == hits[i][1]);
+			assert(contacts[i].info.dist < 4.);
+		}
+		total += n;
+	}
+	assert(total > 0);
+	jwb_world_record_contacts(world, 0);
+	n_hits = 0;
+	jwb_world_step(world);
+	assert(jwb_world_contacts(world, &n) == NULL && n == 0);
+	assert(n_hits > 0);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
@@ -0,0 +1,177 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 200
+#define NUM_FRAMES 60
+#define KEYFRAME_INTERVAL 16
+#define QUANTUM .01
+
+/* The recording, kept in memory. */
+static unsigned char *stream;
+static size_t stream_size, stream_cap;
+
+/* The living entities after each frame, as seen directly. */
+static struct jwb_frame_ent expected[NUM_FRAMES][NUM_ENTS * 2];
+static size_t n_expected[NUM_FRAMES];
+static struct jwb_frame_ent found[NUM_ENTS * 2];
+
+/* A recording with a key frame spawning handle 2^28, then a delta frame
+ * moving handle 5. */
+static const unsigned char sparse[] = {
+	'J', 'W', 'B', 'R', 0x01, 0x01,
+	0x09, 0x01, 0x81, 0x80, 0x80, 0x80, 0x04, 0x00, 0x00, 0x02,
+	0x04, 0x00, 0x14, 0x02, 0x02
+};
+
+static int write_mem(void *ctx, const void *data, size_t size)
+{
+	(void)ctx;
+	if (stream_size + size > stream_cap) {
+		stream_cap = (stream_size + size) * 2;
+		stream = realloc(stream, stream_cap);
+	}
+	memcpy(stream + stream_size, data, size);
+	stream_size += size;
+	return 0;
+}
+
+static int write_fail(void *ctx, const void *data, size_t size)
+{
+	int *n_left = ctx;
+	(void)data;
+	(void)size;
+	return (*n_left)-- <= 0;
+}
+
+/* Note down the living entities, in order of handle, as frame `frame`. */
+static void save_expected(jwb_world_t *world, size_t frame)
+{
+	size_t n = 0;
+	jwb_ehandle_t e;
+	for (e = 0; e < (jwb_ehandle_t)jwb_world_handle_count(world); ++e) {
+		if (jwb_world_confirm_ent(world, e)) {
+			continue;
+		}
+		expected[frame][n].ent = e;
+		jwb_world_get_pos(world, e, &expected[frame][n].pos);
+		expected[frame][n].radius = jwb_world_get_radius(world, e);
+		++n;
+	}
+	n_expected[frame] = n;
+}
+
+static void check_frame(jwb_reader_t *reader, size_t frame)
+{
+	size_t i, n;
+	assert(jwb_reader_frame(reader) == (long)frame);
+	n = jwb_reader_ents(reader, found, NUM_ENTS * 2);
+	assert(n == n_expected[frame]);
+	for (i = 0; i < n; ++i) {
+		const struct jwb_frame_ent *exp = &expected[frame][i];
+		assert(found[i].ent == exp->ent);
+		assert(fabs(found[i].pos.x - exp->pos.x) <= QUANTUM * .51);
+		assert(fabs(found[i].pos.y - exp->pos.y) <= QUANTUM * .51);
+		assert(fabs(found[i].radius - exp->radius) <= QUANTUM * .51);
+	}
+}
+
+static void add_random(jwb_world_t *world)
+{
+	struct jwb_vect pos, vel;
+	pos.x = frand() * 100.;
+	pos.y = frand() * 100.;
+	vel.x = frand() - .5;
+	vel.y = frand() - .5;
+	jwb_world_add_ent(world, &pos, &vel, 1., 1. + frand() * 2.);
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_reader_t reader;
+	size_t i;
+	int n_left;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		add_random(world);
+	}
+	assert(jwb_world_record_frames(world, QUANTUM, KEYFRAME_INTERVAL,
+		write_mem, NULL) == 0);
+	save_expected(world, 0);
+	for (i = 1; i < NUM_FRAMES; ++i) {
+		/* Entities come and go, and sometimes the handles change. */
+		jwb_world_remove_ent(world, rand() % NUM_ENTS);
+		jwb_world_destroy_ent(world, rand() % NUM_ENTS);
+		add_random(world);
+		if (i % 5 == 0) {
+			jwb_world_set_radius(world, jwb_world_first(world), .5);
+		}
+		if (i == NUM_FRAMES / 2) {
+			jwb_world_compact(world, NULL);
+		}
+		jwb_world_step(world);
+		save_expected(world, i);
+	}
+	assert(jwb_world_record_frames(world, 0, 0, NULL, NULL) == 0);
+	/* Mostly small moves are much smaller than full states. */
+	assert(stream_size < NUM_FRAMES * NUM_ENTS * 3 * sizeof(jwb_num_t) / 2);
+
+	assert(jwb_reader_open(&reader, stream, stream_size, NULL) == 0);
+	assert(jwb_reader_frame(&reader) == -1);
+	for (i = 0; i < NUM_FRAMES; ++i) {
+		assert(jwb_reader_next(&reader) == 1);
+		check_frame(&reader, i);
+	}
+	assert(jwb_reader_next(&reader) == 0);
+	for (i = 0; i < 50; ++i) {
+		size_t frame = rand() % NUM_FRAMES;
+		assert(jwb_reader_seek(&reader, frame) == 0);
+		check_frame(&reader, frame);
+	}
+	assert(jwb_reader_seek(&reader, NUM_FRAMES)
+		== -JWBE_INVALID_ARGUMENT);
+	jwb_reader_close(&reader);
+
+	/* Frames cut off at the end are damaged. */
+	assert(jwb_reader_open(&reader, stream, stream_size - 1, NULL) == 0);
+	assert(jwb_reader_seek(&reader, NUM_FRAMES - 1)
+		== -JWBE_BAD_RECORDING);
+	jwb_reader_close(&reader);
+	assert(jwb_reader_open(&reader, "JWBX", 4, NULL)
+		== -JWBE_BAD_RECORDING);
+
+	/* A large handle costs no more than a small one, and one which was
+	 * never spawned can't be moved. */
+	assert(jwb_reader_open(&reader, sparse, sizeof(sparse), NULL) == 0);
+	assert(jwb_reader_next(&reader) == 1);
+	assert(jwb_reader_ents(&reader, found, 2) == 1);
+	assert(found[0].ent == (jwb_ehandle_t)1 << 28);
+	assert(jwb_reader_next(&reader) == -JWBE_BAD_RECORDING);
+	jwb_reader_close(&reader);
+
+	/* Failed writes stop the recording and are reported at the end. */
+	n_left = 3;
+	assert(jwb_world_record_frames(world, QUANTUM, 0, write_fail, &n_left)
+		== 0);
+	for (i = 0; i < 5; ++i) {
+		jwb_world_step(world);
+	}
+	assert(n_left == -1);
+	assert(jwb_world_record_frames(world, 0, 0, NULL, NULL)
+		== -JWBE_IO);
+	assert(jwb_world_record_frames(world, 0., 0, write_mem, NULL)
+		== -JWBE_INVALID_ARGUMENT);
+
+	free(stream);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
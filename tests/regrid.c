@@ -0,0 +1,119 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 300
+
+static size_t count_removed(jwb_world_t *world)
+{
+	size_t n = 0;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first_removed(world);
+	     e >= 0;
+	     e = jwb_world_next_removed(world, e)) {
+		++n;
+	}
+	return n;
+}
+
+static void add_ents(jwb_world_t *world, jwb_num_t extent, jwb_num_t radius)
+{
+	size_t i;
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * extent, pos.y = frand() * extent;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., radius) >= 0);
+	}
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect pos, vel;
+	jwb_ehandle_t e;
+	size_t i;
+	srand(time(NULL));
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.flags = JWBF_REMOVE_DISTANT;
+	jwb_world_alloc(world, &alloc_info);
+	add_ents(world, 100., 2.);
+	/* Entities which fall off the smaller grid are removed. */
+	assert(jwb_world_regrid(world, 5., 10, 20) == 0);
+	assert(fequal(jwb_world_get_cell_size(world), 5.));
+	assert(jwb_world_get_width(world) == 10);
+	assert(jwb_world_get_height(world) == 20);
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect pos;
+		jwb_world_get_pos(world, e, &pos);
+		assert(pos.x < 50.);
+	}
+	assert(jwb_world_living_count(world) + count_removed(world)
+		== NUM_ENTS);
+	for (i = 0; i < 10; ++i) {
+		jwb_world_step(world);
+	}
+	/* The cells cannot be smaller than an entity, even if they are bigger
+	 * than its radius. */
+	assert(jwb_world_regrid(world, 1., 50, 100)
+		== -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_regrid(world, 3., 20, 40)
+		== -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_regrid(world, 0., 50, 100)
+		== -JWBE_INVALID_ARGUMENT);
+	assert(fequal(jwb_world_get_cell_size(world), 5.));
+	assert(jwb_world_regrid(world, 20., 1, 5) == 0);
+	assert(fequal(jwb_world_get_cell_size(world), 20.));
+	assert(jwb_world_get_width(world) == 1);
+	assert(jwb_world_get_height(world) == 5);
+	jwb_world_destroy(world);
+
+	/* One cell thick grids are kept as cells half the size, which must still
+	 * hold every entity. */
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	jwb_world_alloc(world, &alloc_info);
+	pos.x = pos.y = 5.;
+	vel.x = vel.y = 0.;
+	e = jwb_world_add_ent(world, &pos, &vel, 1., 4.);
+	assert(jwb_world_regrid(world, 10., 1, 4) == -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_regrid(world, 16., 1, 4) == 0);
+	assert(fequal(jwb_world_get_cell_size(world), 16.));
+	assert(jwb_world_get_width(world) == 1);
+	assert(jwb_world_get_height(world) == 4);
+	jwb_world_set_radius(world, e, 2.5);
+	assert(jwb_world_regrid(world, 10., 4, 1) == 0);
+	assert(jwb_world_get_width(world) == 4);
+	assert(jwb_world_get_height(world) == 1);
+	jwb_world_destroy(world);
+
+	/* A wrapping world with much too large cells is split up. */
+	alloc_info.cell_size = 80.;
+	alloc_info.width = 4;
+	alloc_info.height = 4;
+	alloc_info.flags = 0;
+	jwb_world_alloc(world, &alloc_info);
+	add_ents(world, 320., 1.);
+	jwb_world_auto_regrid(world, 5);
+	for (i = 0; i < 4; ++i) {
+		jwb_world_step(world);
+	}
+	assert(fequal(jwb_world_get_cell_size(world), 80.));
+	jwb_world_step(world);
+	assert(jwb_world_get_cell_size(world) < 80.);
+	assert(jwb_world_get_cell_size(world) >= 2.);
+	assert(fequal(jwb_world_get_cell_size(world)
+		* jwb_world_get_width(world), 320.));
+	assert(jwb_world_living_count(world) == NUM_ENTS);
+	for (i = 0; i < 20; ++i) {
+		jwb_world_step(world);
+	}
+	assert(jwb_world_living_count(world) == NUM_ENTS);
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 2500
+
+/* The extra data of each entity holds its original handle. */
+static int extra_matches(jwb_world_t *world, jwb_ehandle_t e, jwb_ehandle_t id)
+{
+	jwb_ehandle_t *extra = jwb_world_get_extra(world, e);
+	return extra[0] == id && extra[1] == ~id;
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_ehandle_t remap[NUM_ENTS];
+	jwb_ehandle_t e;
+	size_t i;
+	srand(time(NULL));
+	alloc_info.flags = JWBF_SEPARATE_EXTRA;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_extra = 2 * sizeof(jwb_ehandle_t);
+	jwb_world_alloc(world, &alloc_info);
+	assert(jwb_world_extra_size(world) >= 2 * sizeof(jwb_ehandle_t));
+	/* The buffer grows many times along the way. */
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		jwb_ehandle_t *extra;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand() - .5, vel.y = frand() - .5;
+		e = jwb_world_add_ent(world, &pos, &vel, 1., 1.);
+		extra = jwb_world_get_extra(world, e);
+		extra[0] = e;
+		extra[1] = ~e;
+	}
+	for (e = 0; e < NUM_ENTS; ++e) {
+		assert(extra_matches(world, e, e));
+	}
+	for (i = 0; i < 50; ++i) {
+		jwb_world_step(world);
+	}
+	for (e = 0; e < NUM_ENTS; ++e) {
+		if (rand() % 3 == 0) {
+			jwb_world_destroy_ent(world, e);
+		}
+	}
+	/* Compaction carries the extra data along with the entities. */
+	jwb_world_compact(world, remap);
+	for (e = 0; e < NUM_ENTS; ++e) {
+		if (remap[e] >= 0) {
+			assert(extra_matches(world, remap[e], e));
+		}
+	}
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}
@@ -0,0 +1,217 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 300
+#define NUM_STEPS 20
+
+/* Start a world with some removed and destroyed entities. */
+static void make_world(jwb_world_t *world, int flags, size_t width)
+{
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect gravity;
+	jwb_ehandle_t e;
+	size_t i;
+	alloc_info.flags = flags;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = width;
+	alloc_info.height = 8;
+	alloc_info.ent_extra = sizeof(long);
+	assert(jwb_world_alloc(world, &alloc_info) == 0);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 10. * width;
+		pos.y = frand() * 80.;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		e = jwb_world_add_ent(world, &pos, &vel, 1., 1. + frand() * 3.);
+		*(long *)jwb_world_get_extra(world, e) = (long)i * 3;
+	}
+	for (i = 0; i < NUM_ENTS; i += 5) {
+		jwb_world_remove_ent(world, i);
+	}
+	for (i = 1; i < NUM_ENTS; i += 11) {
+		jwb_world_destroy_ent(world, i);
+	}
+	gravity.x = 0.;
+	gravity.y = .1;
+	jwb_world_set_gravity(world, &gravity);
+	jwb_world_track(world, 3);
+	jwb_world_step(world);
+}
+
+/* Check that two worlds have the same entities and settings. */
+static void check_same(jwb_world_t *w1, jwb_world_t *w2)
+{
+	jwb_ehandle_t e1, e2;
+	struct jwb_vect v1, v2;
+	assert(jwb_world_handle_count(w1) == jwb_world_handle_count(w2));
+	assert(jwb_world_living_count(w1) == jwb_world_living_count(w2));
+	assert(jwb_world_tracking(w1) == jwb_world_tracking(w2));
+	assert(jwb_world_get_width(w1) == jwb_world_get_width(w2));
+	assert(jwb_world_get_cell_size(w1) == jwb_world_get_cell_size(w2));
+	jwb_world_get_gravity(w1, &v1);
+	jwb_world_get_gravity(w2, &v2);
+	assert(v1.x == v2.x && v1.y == v2.y);
+	for (e1 = jwb_world_first(w1), e2 = jwb_world_first(w2); e1 >= 0;
+	     e1 = jwb_world_next(w1, e1), e2 = jwb_world_next(w2, e2)) {
+		assert(e1 == e2);
+		jwb_world_get_pos(w1, e1, &v1);
+		jwb_world_get_pos(w2, e2, &v2);
+		assert(v1.x == v2.x && v1.y == v2.y);
+		jwb_world_get_vel(w1, e1, &v1);
+		jwb_world_get_vel(w2, e2, &v2);
+		assert(v1.x == v2.x && v1.y == v2.y);
+		assert(jwb_world_get_radius(w1, e1)
+			== jwb_world_get_radius(w2, e2));
+		assert(*(long *)jwb_world_get_extra(w1, e1)
+			== *(long *)jwb_world_get_extra(w2, e2));
+	}
+	assert(e2 < 0);
+}
+
+/* Check that two worlds go on the same way, adding `n_add` entities in the
+ * same places. */
+static void check_continues(jwb_world_t *w1, jwb_world_t *w2, int n_add)
+{
+	struct jwb_vect pos = {5., 5.}, vel = {0., 0.};
+	int i;
+	for (i = 0; i < NUM_STEPS; ++i) {
+		jwb_world_step(w1);
+		jwb_world_step(w2);
+	}
+	check_same(w1, w2);
+	for (i = 0; i < n_add; ++i) {
+		jwb_ehandle_t e = jwb_world_add_ent(w1, &pos, &vel, 1., 1.);
+		assert(jwb_world_add_ent(w2, &pos, &vel, 1., 1.) == e);
+		*(long *)jwb_world_get_extra(w1, e) = i;
+		*(long *)jwb_world_get_extra(w2, e) = i;
+	}
+	check_same(w1, w2);
+}
+
+/* Find a stored entity in a snapshot by its position. */
+static struct jwb__entity *find_saved(const struct jwb_vect *pos, char *data,
+	long size)
+{
+	long i, end = size - (long)sizeof(*pos);
+	for (i = offsetof(struct jwb__entity, pos); i <= end; ++i) {
+		if (!memcmp(data + i, pos, sizeof(*pos))) {
+			return (struct jwb__entity *)
+				(data + i - offsetof(struct jwb__entity, pos));
+		}
+	}
+	assert(!"entity not found");
+	return NULL;
+}
+
+static void test_snapshot(int flags, size_t width)
+{
+	jwb_world_t world, loaded, mapped;
+	jwb_ehandle_t bad;
+	struct jwb__entity *saved;
+	struct jwb_vect pos;
+	FILE *file = tmpfile(), *damaged;
+	char *data;
+	long size;
+	size_t n_handles;
+	int err;
+	make_world(&world, flags, width);
+	assert(file);
+	assert(jwb_world_save(&world, file) == 0);
+	size = ftell(file);
+	n_handles = jwb_world_handle_count(&world);
+	jwb_world_get_pos(&world, jwb_world_first(&world), &pos);
+
+	rewind(file);
+	assert(jwb_world_load(&loaded, file, NULL) == 0);
+	check_same(&world, &loaded);
+	check_continues(&world, &loaded, NUM_ENTS / 5);
+	jwb_world_destroy(&loaded);
+
+	rewind(file);
+	data = malloc(size);
+	assert(fread(data, 1, size, file) == (size_t)size);
+	err = jwb_world_load_mapped(&mapped, data, size, NULL);
+#ifdef JWBO_PAGED_ENTS
+	assert(err == -JWBE_INVALID_ARGUMENT);
+#else
+	assert(err == 0);
+	rewind(file);
+	assert(jwb_world_load(&loaded, file, NULL) == 0);
+	check_same(&loaded, &mapped);
+	/* Mapped worlds can only reuse the handles of destroyed entities. */
+	check_continues(&loaded, &mapped, 10);
+	jwb_world_destroy(&mapped);
+	jwb_world_destroy(&loaded);
+	/* Damaged snapshots are refused. */
+	assert(jwb_world_load_mapped(&mapped, data, size - 1, NULL)
+		== -JWBE_BAD_SNAPSHOT);
+	data[0] = 'X';
+	assert(jwb_world_load_mapped(&mapped, data, size, NULL)
+		== -JWBE_BAD_SNAPSHOT);
+#endif
+	free(data);
+
+	/* A dense list naming a handle which does not exist. */
+	rewind(file);
+	data = malloc(size);
+	assert(fread(data, 1, size, file) == (size_t)size);
+	bad = (jwb_ehandle_t)n_handles + 5;
+	memcpy(data + size - n_handles * sizeof(bad), &bad, sizeof(bad));
+	damaged = tmpfile();
+	fwrite(data, 1, size, damaged);
+	rewind(damaged);
+	assert(jwb_world_load(&loaded, damaged, NULL) == -JWBE_BAD_SNAPSHOT);
+	fclose(damaged);
+#ifndef JWBO_PAGED_ENTS
+	assert(jwb_world_load_mapped(&mapped, data, size, NULL)
+		== -JWBE_BAD_SNAPSHOT);
+#endif
+	free(data);
+
+	/* A living entity linked to a handle which does not exist. */
+	rewind(file);
+	data = malloc(size);
+	assert(fread(data, 1, size, file) == (size_t)size);
+	saved = find_saved(&pos, data, size);
+	bad = 100000000;
+	memcpy((char *)saved + offsetof(struct jwb__entity, last), &bad,
+		sizeof(bad));
+	damaged = tmpfile();
+	fwrite(data, 1, size, damaged);
+	rewind(damaged);
+	assert(jwb_world_load(&loaded, damaged, NULL) == -JWBE_BAD_SNAPSHOT);
+	fclose(damaged);
+#ifndef JWBO_PAGED_ENTS
+	assert(jwb_world_load_mapped(&mapped, data, size, NULL)
+		== -JWBE_BAD_SNAPSHOT);
+#endif
+	free(data);
+
+	/* A file cut off partway through. */
+	rewind(file);
+	data = malloc(size / 2);
+	assert(fread(data, 1, size / 2, file) == (size_t)size / 2);
+	fclose(file);
+	file = tmpfile();
+	fwrite(data, 1, size / 2, file);
+	rewind(file);
+	assert(jwb_world_load(&loaded, file, NULL) == -JWBE_BAD_SNAPSHOT);
+	free(data);
+	jwb_world_destroy(&world);
+	fclose(file);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	test_snapshot(0, 10);
+	test_snapshot(JWBF_WALLED | JWBF_SEPARATE_EXTRA, 10);
+	test_snapshot(JWBF_REMOVE_DISTANT, 1);
+	assert(jwb_world_save(NULL, NULL) == -JWBE_INVALID_ARGUMENT);
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 10
+
+static jwb_world_t *make_world(int seed)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	size_t i;
+	alloc_info.cell_size = 10.;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_buf_size = NUM_ENTS;
+	jwb_world_alloc(world, &alloc_info);
+	srand(seed);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 100., pos.y = frand() * 100.;
+		vel.x = frand(), vel.y = frand();
+		jwb_world_add_ent(world, &pos, &vel, frand() + 0.5, frand());
+	}
+	return world;
+}
+
+static void free_world(jwb_world_t *world)
+{
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	jwb_world_t *world1, *world2;
+	struct jwb_vect pos, vel;
+	jwb_ehandle_t e1, e2;
+	size_t i;
+	int seed = time(NULL);
+	/* Unit substeps are the same as normal steps. */
+	world1 = make_world(seed);
+	world2 = make_world(seed);
+	for (i = 0; i < 100; ++i) {
+		jwb_world_step(world1);
+	}
+	assert(jwb_world_step_dt(world2, 100., 100) == 0);
+	for (e1 = jwb_world_first(world1), e2 = jwb_world_first(world2);
+	     e1 >= 0 && e2 >= 0;
+	     e1 = jwb_world_next(world1, e1), e2 = jwb_world_next(world2, e2))
+	{
+		struct jwb_vect pos1, pos2;
+		jwb_world_get_pos(world1, e1, &pos1);
+		jwb_world_get_pos(world2, e2, &pos2);
+		assert(pos1.x == pos2.x && pos1.y == pos2.y);
+	}
+	assert(e1 < 0 && e2 < 0);
+	free_world(world1);
+	free_world(world2);
+	/* Velocity is scaled by the time step. */
+	world1 = make_world(seed);
+	while ((e1 = jwb_world_first(world1)) >= 0) {
+		jwb_world_destroy_ent(world1, e1);
+	}
+	pos.x = pos.y = 50.;
+	vel.x = 2.;
+	vel.y = -1.;
+	e1 = jwb_world_add_ent(world1, &pos, &vel, 1., 1.);
+	assert(jwb_world_step_dt(world1, 2.5, 3) == 0);
+	jwb_world_get_pos(world1, e1, &pos);
+	assert(fequal(pos.x, 55.));
+	assert(fequal(pos.y, 47.5));
+	assert(jwb_world_step_dt(world1, 1., 0) == -JWBE_INVALID_ARGUMENT);
+	assert(jwb_world_step_dt(world1, -1., 1) == -JWBE_INVALID_ARGUMENT);
+	free_world(world1);
+	return 0;
+}
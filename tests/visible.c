@@ -0,0 +1,136 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ENTS 1000
+#define NUM_VIEWS 200
+#define MAX_VISIBLE (NUM_ENTS * 16)
+#define CELL_SIZE 5.
+#define WIDTH 20
+#define HEIGHT 15
+
+static struct jwb_visible found[MAX_VISIBLE];
+static int expected[NUM_ENTS];
+
+/* Check whether a circle touches a rectangle. */
+static int touches(double x, double y, double r, const struct jwb_vect *min,
+	const struct jwb_vect *max)
+{
+	double gx = x < min->x ? min->x - x : x > max->x ? x - max->x : 0.;
+	double gy = y < min->y ? min->y - y : y > max->y ? y - max->y : 0.;
+	return gx * gx + gy * gy <= r * r;
+}
+
+/* Get how far a number is from being a multiple of `lim`. */
+static double off_multiple(double num, double lim)
+{
+	double rem = fmod(num, lim);
+	if (rem < 0.) {
+		rem += lim;
+	}
+	return rem < lim - rem ? rem : lim - rem;
+}
+
+static void test_views(int flags)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	struct jwb_vect off;
+	double lim_x = WIDTH * CELL_SIZE, lim_y = HEIGHT * CELL_SIZE;
+	int wrap = !flags;
+	size_t i, j;
+	jwb_ehandle_t e;
+	alloc_info.cell_size = CELL_SIZE;
+	alloc_info.width = WIDTH;
+	alloc_info.height = HEIGHT;
+	alloc_info.flags = flags;
+	jwb_world_alloc(world, &alloc_info);
+	off.x = 17.;
+	off.y = -40.;
+	jwb_world_offset(world, &off);
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = off.x + frand() * lim_x;
+		pos.y = off.y + frand() * lim_y;
+		vel.x = frand() - .5;
+		vel.y = frand() - .5;
+		jwb_world_add_ent(world, &pos, &vel, 1., frand() * CELL_SIZE);
+	}
+	jwb_world_step(world);
+	for (i = 0; i < NUM_VIEWS; ++i) {
+		struct jwb_vect min, max;
+		size_t n;
+		/* Views relative to the offset, sometimes bigger than the grid. */
+		min.x = (frand() * 2. - .5) * lim_x;
+		min.y = (frand() * 2. - .5) * lim_y;
+		max.x = min.x + frand() * lim_x * 1.5;
+		max.y = min.y + frand() * lim_y * 1.5;
+		memset(expected, 0, sizeof(expected));
+		for (e = jwb_world_first(world); e >= 0;
+		     e = jwb_world_next(world, e)) {
+			struct jwb_vect pos;
+			double r = jwb_world_get_radius(world, e);
+			int kx, ky;
+			jwb_world_get_pos(world, e, &pos);
+			pos.x -= off.x;
+			pos.y -= off.y;
+			if (!wrap) {
+				expected[e] = touches(pos.x, pos.y, r, &min,
+					&max);
+				continue;
+			}
+			pos.x = fmod(pos.x, lim_x) + (pos.x < 0. ? lim_x : 0.);
+			pos.y = fmod(pos.y, lim_y) + (pos.y < 0. ? lim_y : 0.);
+			for (kx = -3; kx <= 3; ++kx) {
+				for (ky = -3; ky <= 3; ++ky) {
+					expected[e] += touches(
+						pos.x + kx * lim_x,
+						pos.y + ky * lim_y,
+						r, &min, &max);
+				}
+			}
+		}
+		n = jwb_world_visible(world, &min, &max, found, MAX_VISIBLE);
+		assert(n <= MAX_VISIBLE);
+		for (j = 0; j < n; ++j) {
+			struct jwb_vect pos;
+			e = found[j].ent;
+			jwb_world_get_pos(world, e, &pos);
+			assert(fequal(found[j].radius,
+				jwb_world_get_radius(world, e)));
+			/* Each one is where the entity or a copy of it is. */
+			if (wrap) {
+				assert(off_multiple(found[j].pos.x - pos.x
+					+ off.x, lim_x) < .001);
+				assert(off_multiple(found[j].pos.y - pos.y
+					+ off.y, lim_y) < .001);
+			} else {
+				assert(fequal(found[j].pos.x, pos.x - off.x));
+				assert(fequal(found[j].pos.y, pos.y - off.y));
+			}
+			assert(touches(found[j].pos.x, found[j].pos.y,
+				found[j].radius, &min, &max));
+			assert(expected[e] > 0);
+			--expected[e];
+		}
+		for (j = 0; j < NUM_ENTS; ++j) {
+			assert(expected[j] == 0);
+		}
+		/* Only as many as fit are stored. */
+		assert(jwb_world_visible(world, &min, &max, NULL, 0) == n);
+	}
+	jwb_world_destroy(world);
+	free(world);
+}
+
+int main(void)
+{
+	srand(time(NULL));
+	test_views(0);
+	test_views(JWBF_WALLED);
+	test_views(JWBF_REMOVE_DISTANT);
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include "test.h"
+#include <jwb.h>
+#include <assert.h>
+#include <time.h>
+
+#define NUM_ENTS 20
+
+static jwb_num_t get_total_energy(jwb_world_t *world)
+{
+	jwb_num_t energy = 0.;
+	jwb_ehandle_t e;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect vel;
+		jwb_world_get_vel_unck(world, e, &vel);
+		energy += jwb_world_get_mass_unck(world, e)
+			* (vel.x*vel.x + vel.y*vel.y) / 2;
+	}
+	return energy;
+}
+
+int main(void)
+{
+	jwb_world_t *world = malloc(sizeof(*world));
+	struct jwb_world_init alloc_info = JWB_WORLD_INIT_DEFAULT;
+	jwb_num_t energy_i, energy_f;
+	jwb_ehandle_t e;
+	size_t i, n;
+	alloc_info.cell_size = 10.;
+	alloc_info.flags = JWBF_WALLED;
+	alloc_info.width = 10;
+	alloc_info.height = 10;
+	alloc_info.ent_buf_size = NUM_ENTS;
+	jwb_world_alloc(world, &alloc_info);
+	srand(time(NULL));
+	for (i = 0; i < NUM_ENTS; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = frand() * 80. + 10., pos.y = frand() * 80. + 10.;
+		vel.x = frand() * 6. - 3., vel.y = frand() * 6. - 3.;
+		jwb_world_add_ent(world, &pos, &vel, frand() + 0.5, frand() + 1.);
+	}
+	energy_i = get_total_energy(world);
+	for (i = 0; i < 1000; ++i) {
+		jwb_world_step(world);
+	}
+	energy_f = get_total_energy(world);
+	assert(fequal(energy_i, energy_f));
+	n = 0;
+	for (e = jwb_world_first(world); e >= 0; e = jwb_world_next(world, e)) {
+		struct jwb_vect pos;
+		jwb_num_t radius;
+		jwb_world_get_pos(world, e, &pos);
+		radius = jwb_world_get_radius(world, e);
+		assert(pos.x >= radius && pos.x <= 100. - radius);
+		assert(pos.y >= radius && pos.y <= 100. - radius);
+		++n;
+	}
+	assert(n == NUM_ENTS);
+	assert(jwb_world_first_removed(world) < 0);
+	jwb_world_destroy(world);
+
+	/* A world one cell high still moves and collides entities in every
+	 * cell. */
+	alloc_info.height = 1;
+	jwb_world_alloc(world, &alloc_info);
+	for (i = 0; i < 2; ++i) {
+		struct jwb_vect pos, vel;
+		pos.x = i ? 82.5 : 78., pos.y = 5.;
+		vel.x = i ? -1. : 1., vel.y = 0.;
+		assert(jwb_world_add_ent(world, &pos, &vel, 1., 1.) == (jwb_ehandle_t)i);
+	}
+	for (i = 0; i < 10; ++i) {
+		jwb_world_step(world);
+	}
+	for (i = 0; i < 2; ++i) {
+		struct jwb_vect pos, vel;
+		jwb_world_get_pos(world, i, &pos);
+		jwb_world_get_vel(world, i, &vel);
+		assert(i ? pos.x > 82.5 && vel.x > 0. : pos.x < 78. && vel.x < 0.);
+	}
+	jwb_world_destroy(world);
+	free(world);
+	return 0;
+}